@@ -0,0 +1,13 @@
+#ifndef __INCLUDE_H__
+#define __INCLUDE_H__
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/debug.h"
+#include "utils/stats.h"
+#include "utils/utils.h"
+
+#endif // __INCLUDE_H__
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "include.h"
+#include "tsp/tspApi.h"
+#include "tsp/tspSolver.h"
+#include <getopt.h>
+#include <omp.h>
+
+FILE* openFile(const char* path, const char* mode) {
+    FILE* file = fopen(path, mode);
+    if (file == NULL) {
+        printf("Unable to open the file: %s\n", path);
+        exit(1);
+    }
+    return file;
+}
+
+tsp_t parseInput(const char* inPath) {
+    FILE* inputFile = openFile(inPath, "r");
+    size_t nCities, nRoads;
+    fscanf(inputFile, "%lu %lu\n", &nCities, &nRoads);
+    tsp_t tsp = tspCreate(nCities, nRoads);
+
+    for (int i = 0; i < tsp.nRoads; i++) {
+        int cityA, cityB;
+        double cost;
+        fscanf(inputFile, "%d %d %le\n", &cityA, &cityB, &cost);
+        tsp.roadCosts[cityA][cityB] = cost;
+        tsp.roadCosts[cityB][cityA] = cost;
+    }
+
+    fclose(inputFile);
+    tspInitializeMinCosts(&tsp);
+    return tsp;
+}
+
+void printSolution(const tsp_t* tsp, const tspSolution_t* solution) {
+    if (solution->hasSolution) {
+        printf("%.1f\n", solution->cost);
+        for (int i = 0; i < tsp->nCities; i++)
+            printf("%d ", solution->tour[i]);
+        printf("0\n");
+    } else {
+        printf("NO SOLUTION\n");
+    }
+}
+
+void printUsage() {
+    printf("Usage: ./tsp [-t <num_threads>] [-a none|compact|scatter] [--funneled] <cities_file> <max_value>\n");
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    const struct option options[] = {
+        {"threads", required_argument, NULL, 't'},
+        {"affinity", required_argument, NULL, 'a'},
+        {"funneled", no_argument, NULL, 'f'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int nThreads = threadDefaultCount();
+    threadPolicy_t policy = THREAD_POLICY_NONE;
+    int threadLevel = MPI_THREAD_MULTIPLE;
+    int option;
+    while ((option = getopt_long(argc, argv, "t:a:f", options, NULL)) != -1) {
+        switch (option) {
+        case 't':
+            nThreads = atoi(optarg);
+            break;
+        case 'a':
+            if (!threadParsePolicy(optarg, &policy))
+                printUsage();
+            break;
+        case 'f':
+            threadLevel = MPI_THREAD_FUNNELED;
+            break;
+        default:
+            printUsage();
+        }
+    }
+
+    if (nThreads < 1 || argc - optind != 2)
+        printUsage();
+
+    tspApi_t* api = tspApiCreate();
+    tspApiInit(api, &argc, &argv, threadLevel);
+
+    const char* inPath = argv[optind];
+    double maxTourCost = atoi(argv[optind + 1]);
+    LOG("nThreads = %d", nThreads);
+    LOG("inPath = %s", inPath);
+    LOG("maxTourCost = %f", maxTourCost);
+    threadPlacement_t* placement = threadPlacementCreate(policy);
+    tsp_t tsp = parseInput(inPath);
+    DEBUG(tspPrint(&tsp));
+
+    double execTime = -omp_get_wtime();
+    tspSolution_t* solution = tspSolve(&tsp, maxTourCost, nThreads, placement, api);
+    execTime += omp_get_wtime();
+
+    if (api->procId == 0) {
+        fprintf(stderr, "%.1fs\n", execTime);
+        printSolution(&tsp, solution);
+    }
+
+    tspSolutionDestroy(solution);
+    tspDestroy(&tsp);
+    threadPlacementDestroy(placement);
+    tspApiTerminate(api);
+    tspApiDestroy(api);
+    return 0;
+}
@@ -0,0 +1,263 @@
+#include "tspCluster.h"
+#include <math.h>
+#include <omp.h>
+
+// the termination token adds up the work messages sent minus the ones received by the ranks it visited
+typedef struct {
+    int count;
+    int isBlack;
+} tspToken_t;
+
+struct _tspCluster {
+    tspApi_t* api;
+    tspIncumbent_t* incumbent;
+    tspLoadBalancer_t* loadBalancer;
+    bool terminated;
+    unsigned int seed;
+    int workCount;
+    bool isBlack;
+    bool hasToken;
+    tspToken_t token;
+    double sharedPriority;
+    int* nSentSolutions;
+    int nRecvSolutions;
+    unsigned long nRequests;
+    unsigned long nRecvNodes;
+    unsigned long nTokenRounds;
+};
+
+tspCluster_t* tspClusterCreate(tspApi_t* api, tspIncumbent_t* incumbent, tspLoadBalancer_t* loadBalancer) {
+    tspCluster_t* cluster = (tspCluster_t*)malloc(sizeof(tspCluster_t));
+    cluster->api = api;
+    cluster->incumbent = incumbent;
+    cluster->loadBalancer = loadBalancer;
+    cluster->terminated = false;
+    cluster->seed = (unsigned int)api->procId;
+    cluster->workCount = 0;
+    cluster->isBlack = false;
+    cluster->hasToken = (api->procId == 0);
+    cluster->token.count = 0;
+    cluster->token.isBlack = true;
+    cluster->sharedPriority = INFINITY;
+    cluster->nSentSolutions = (int*)calloc(api->nProcs, sizeof(int));
+    cluster->nRecvSolutions = 0;
+    cluster->nRequests = 0;
+    cluster->nRecvNodes = 0;
+    cluster->nTokenRounds = 0;
+    return cluster;
+}
+
+void tspClusterDestroy(tspCluster_t* cluster) {
+    free(cluster->nSentSolutions);
+    free(cluster);
+}
+
+bool tspClusterIsTerminated(tspCluster_t* cluster) { return cluster->terminated; }
+
+static bool _lowerSharedPriority(tspCluster_t* cluster, double priority) {
+    double sharedPriority;
+    __atomic_load(&cluster->sharedPriority, &sharedPriority, __ATOMIC_RELAXED);
+    do {
+        if (priority >= sharedPriority)
+            return false;
+    } while (!__atomic_compare_exchange(&cluster->sharedPriority, &sharedPriority, &priority, true, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_RELAXED));
+    return true;
+}
+
+static void _shareSolution(tspCluster_t* cluster) {
+    tspSolution_t solution;
+    tspIncumbentSnapshot(cluster->incumbent, &solution);
+    if (!solution.hasSolution || !_lowerSharedPriority(cluster, solution.priority))
+        return;
+
+    for (int i = 0; i < cluster->api->nProcs; i++) {
+        if (i == cluster->api->procId)
+            continue;
+        MPI_Send(&solution, 1, cluster->api->solution_t, i, MPI_TAG_SOLUTION, MPI_COMM_WORLD);
+        __atomic_fetch_add(&cluster->nSentSolutions[i], 1, __ATOMIC_RELAXED);
+    }
+}
+
+// with MPI_THREAD_FUNNELED the tour is only sent by the master thread on its next poll
+void tspClusterNotifySolution(tspCluster_t* cluster) {
+    if (cluster->api->threadLevel == MPI_THREAD_MULTIPLE || omp_get_thread_num() == 0)
+        _shareSolution(cluster);
+}
+
+static void _recvSolution(tspCluster_t* cluster, const MPI_Status* status) {
+    tspSolution_t solution;
+    MPI_Recv(&solution, 1, cluster->api->solution_t, status->MPI_SOURCE, MPI_TAG_SOLUTION, MPI_COMM_WORLD,
+             MPI_STATUS_IGNORE);
+    cluster->nRecvSolutions++;
+    if (tspIncumbentOffer(cluster->incumbent, &solution))
+        _lowerSharedPriority(cluster, solution.priority);
+}
+
+static void _serveRequest(tspCluster_t* cluster, const MPI_Status* status) {
+    MPI_Recv(NULL, 0, MPI_BYTE, status->MPI_SOURCE, MPI_TAG_ASK_NODE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+    tspNode_t nodes[CLUSTER_STEAL_BATCH];
+    int nNodes = 0;
+    double solutionPriority = tspIncumbentPriority(cluster->incumbent);
+    while (!cluster->terminated && nNodes < CLUSTER_STEAL_BATCH) {
+        tspNode_t* node = tspLoadBalancerTryPop(cluster->loadBalancer, solutionPriority);
+        if (node == NULL)
+            break;
+        nodes[nNodes++] = *node;
+        tspNodeDestroy(node);
+    }
+    MPI_Send(nodes, nNodes, cluster->api->node_t, status->MPI_SOURCE, MPI_TAG_NODE, MPI_COMM_WORLD);
+    if (nNodes > 0)
+        cluster->workCount++;
+}
+
+static void _terminate(tspCluster_t* cluster) {
+    for (int i = 1; i < cluster->api->nProcs; i++)
+        MPI_Send(NULL, 0, MPI_BYTE, i, MPI_TAG_TERMINATED, MPI_COMM_WORLD);
+    cluster->terminated = true;
+}
+
+void tspClusterPoll(tspCluster_t* cluster) {
+    if (cluster->api->threadLevel != MPI_THREAD_MULTIPLE)
+        _shareSolution(cluster);
+
+    while (true) {
+        int flag;
+        MPI_Status status;
+        MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &flag, &status);
+        if (!flag || status.MPI_TAG == MPI_TAG_NODE)
+            break;
+
+        if (status.MPI_TAG == MPI_TAG_SOLUTION) {
+            _recvSolution(cluster, &status);
+        } else if (status.MPI_TAG == MPI_TAG_ASK_NODE) {
+            _serveRequest(cluster, &status);
+        } else if (status.MPI_TAG == MPI_TAG_TOKEN) {
+            MPI_Recv(&cluster->token, 2, MPI_INT, status.MPI_SOURCE, MPI_TAG_TOKEN, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            cluster->hasToken = true;
+        } else {
+            MPI_Recv(NULL, 0, MPI_BYTE, status.MPI_SOURCE, status.MPI_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            if (status.MPI_TAG == MPI_TAG_TERMINATED)
+                cluster->terminated = true;
+        }
+    }
+}
+
+// Safra's algorithm: passive ranks pass the token around the ring, and it returns to rank 0 white with a zero count
+// only if every rank stayed passive and no work message is in flight
+static void _passToken(tspCluster_t* cluster) {
+    tspApi_t* api = cluster->api;
+    tspToken_t* token = &cluster->token;
+    if (!cluster->hasToken || cluster->terminated)
+        return;
+
+    if (api->procId == 0) {
+        if (api->nProcs == 1 || (!token->isBlack && !cluster->isBlack && token->count + cluster->workCount == 0)) {
+            _terminate(cluster);
+            return;
+        }
+        token->count = 0;
+        token->isBlack = false;
+        STATS(cluster->nTokenRounds++);
+    } else {
+        token->count += cluster->workCount;
+        token->isBlack |= cluster->isBlack;
+    }
+    cluster->isBlack = false;
+    cluster->hasToken = false;
+    MPI_Send(token, 2, MPI_INT, (api->procId + 1) % api->nProcs, MPI_TAG_TOKEN, MPI_COMM_WORLD);
+}
+
+static int _recvNodes(tspCluster_t* cluster, int victim) {
+    MPI_Status status;
+    int flag = false;
+    while (true) {
+        MPI_Iprobe(victim, MPI_TAG_NODE, MPI_COMM_WORLD, &flag, &status);
+        if (flag)
+            break;
+        tspClusterPoll(cluster);
+        _passToken(cluster);
+    }
+
+    tspNode_t buffer[CLUSTER_STEAL_BATCH];
+    int nNodes;
+    MPI_Recv(buffer, CLUSTER_STEAL_BATCH, cluster->api->node_t, victim, MPI_TAG_NODE, MPI_COMM_WORLD, &status);
+    MPI_Get_count(&status, cluster->api->node_t, &nNodes);
+
+    tspNode_t* nodes[CLUSTER_STEAL_BATCH];
+    for (int i = 0; i < nNodes; i++) {
+        nodes[i] = tspNodeCreate(0, 0, 1, 0);
+        *nodes[i] = buffer[i];
+    }
+    tspLoadBalancerPushBatch(cluster->loadBalancer, nodes, nNodes);
+    if (nNodes > 0) {
+        cluster->workCount--;
+        cluster->isBlack = true;
+    }
+    STATS(cluster->nRecvNodes += nNodes);
+    return nNodes;
+}
+
+// an idle rank asks a random victim for nodes, passing the token while it waits, and asks again the next time it is
+// found idle
+void tspClusterRequestWork(tspCluster_t* cluster) {
+    int nProcs = cluster->api->nProcs;
+    int procId = cluster->api->procId;
+    _passToken(cluster);
+    if (cluster->terminated)
+        return;
+
+    int victim = (procId + 1 + rand_r(&cluster->seed) % (nProcs - 1)) % nProcs;
+    MPI_Send(NULL, 0, MPI_BYTE, victim, MPI_TAG_ASK_NODE, MPI_COMM_WORLD);
+    STATS(cluster->nRequests++);
+    _recvNodes(cluster, victim);
+}
+
+#ifdef __STATS__
+static void _logStats(tspCluster_t* cluster) {
+    unsigned long local[2] = {cluster->nRequests, cluster->nRecvNodes};
+    unsigned long total[2] = {0, 0};
+    MPI_Reduce(local, total, 2, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (cluster->api->procId == 0) {
+        STATS_LOG("work requests = %lu", total[0]);
+        STATS_LOG("transferred nodes = %lu", total[1]);
+        STATS_LOG("termination token rounds = %lu", cluster->nTokenRounds);
+    }
+}
+#endif
+
+// the work requests still in flight are answered before the ranks leave, so no message is left unmatched
+static void _drainRequests(tspCluster_t* cluster) {
+    MPI_Request request;
+    int isDrained = false;
+    MPI_Ibarrier(MPI_COMM_WORLD, &request);
+    while (!isDrained) {
+        tspClusterPoll(cluster);
+        MPI_Test(&request, &isDrained, MPI_STATUS_IGNORE);
+    }
+}
+
+tspSolution_t* tspClusterSolution(tspCluster_t* cluster) {
+    _drainRequests(cluster);
+
+    // the tours sent right before the termination may still be in flight
+    int nExpected;
+    MPI_Reduce_scatter_block(cluster->nSentSolutions, &nExpected, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    while (cluster->nRecvSolutions < nExpected) {
+        MPI_Status status;
+        MPI_Probe(MPI_ANY_SOURCE, MPI_TAG_SOLUTION, MPI_COMM_WORLD, &status);
+        _recvSolution(cluster, &status);
+    }
+
+    tspSolution_t* solution = tspIncumbentSolution(cluster->incumbent);
+    struct {
+        double priority;
+        int procId;
+    } local = {solution->priority, cluster->api->procId}, best;
+    MPI_Allreduce(&local, &best, 1, MPI_DOUBLE_INT, MPI_MINLOC, MPI_COMM_WORLD);
+    MPI_Bcast(solution, 1, cluster->api->solution_t, best.procId, MPI_COMM_WORLD);
+
+    STATS(_logStats(cluster));
+    return solution;
+}
@@ -0,0 +1,23 @@
+#ifndef __TSP__TSP_CLUSTER_H__
+#define __TSP__TSP_CLUSTER_H__
+
+#include "include.h"
+#include "tspApi.h"
+#include "tspIncumbent.h"
+#include "tspLoadBalancer.h"
+
+#define CLUSTER_STEAL_BATCH 16
+
+typedef struct _tspCluster tspCluster_t;
+
+tspCluster_t* tspClusterCreate(tspApi_t* api, tspIncumbent_t* incumbent, tspLoadBalancer_t* loadBalancer);
+void tspClusterDestroy(tspCluster_t* cluster);
+
+void tspClusterPoll(tspCluster_t* cluster);
+void tspClusterRequestWork(tspCluster_t* cluster);
+void tspClusterNotifySolution(tspCluster_t* cluster);
+tspSolution_t* tspClusterSolution(tspCluster_t* cluster);
+
+bool tspClusterIsTerminated(tspCluster_t* cluster);
+
+#endif // __TSP__TSP_CLUSTER_H__
@@ -0,0 +1,517 @@
+#include "tspLoadBalancer.h"
+#include "tspNodePool.h"
+#include "utils/queue.h"
+#include <math.h>
+#include <omp.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define LB_STEAL_BATCH 16
+#define LB_MULTIQUEUE_FACTOR 2
+#define LB_MULTIQUEUE_RETRIES 4
+#define LB_SPIN_MIN 16
+#define LB_SPIN_MAX 1024
+#define LB_PURGE_MIN_NODES 1024
+#define LB_PURGE_MIN_IMPROVEMENT 0.01
+
+#ifdef __MULTIQUEUE__
+#define LB_QUEUES_PER_THREAD LB_MULTIQUEUE_FACTOR
+#else
+#define LB_QUEUES_PER_THREAD 1
+#endif
+
+static int __tspNodeCmpFun(void* el1, void* el2) {
+    tspNode_t* node1 = (tspNode_t*)el1;
+    tspNode_t* node2 = (tspNode_t*)el2;
+    return (node2->priority < node1->priority ? 1 : 0);
+}
+
+static void __tspNodeDestroyFun(void* el) {
+    tspNode_t* node = (tspNode_t*)el;
+    tspNodeDestroy(node);
+}
+
+static bool __tspNodeIsPromisingFun(void* el, void* arg) {
+    tspNode_t* node = (tspNode_t*)el;
+    return node->priority <= *(double*)arg;
+}
+
+typedef struct {
+    priorityQueue_t* queue;
+    omp_lock_t queueLock;
+    double topPriority;
+} queueInfo_t;
+
+queueInfo_t* queueInfoCreate() {
+    queueInfo_t* queueInfo = (queueInfo_t*)malloc(sizeof(queueInfo_t));
+    queueInfo->queue = queueCreate(__tspNodeCmpFun);
+    omp_init_lock(&queueInfo->queueLock);
+    queueInfo->topPriority = INFINITY;
+    return queueInfo;
+}
+
+void queueInfoDestroy(queueInfo_t* queueInfo) {
+    omp_destroy_lock(&queueInfo->queueLock);
+    queueDestroy(queueInfo->queue, __tspNodeDestroyFun);
+    free(queueInfo);
+}
+
+typedef struct {
+    CACHE_ALIGNED bool parked;
+    unsigned int seed;
+    int spinLimit;
+    double purgePriority;
+    pthread_cond_t threadWait;
+    pthread_mutex_t threadWaitLock;
+    unsigned long nPops;
+    unsigned long rankError;
+    unsigned long nParks;
+    unsigned long nWakes;
+    unsigned long nPurged;
+    double idleTime;
+    double wakeTime;
+    double wakeLatency;
+} threadInfo_t;
+
+threadInfo_t* threadInfoCreate(unsigned int seed) {
+    threadInfo_t* threadInfo = NULL;
+    posix_memalign((void**)&threadInfo, CACHE_LINE_SIZE, sizeof(threadInfo_t));
+    threadInfo->parked = false;
+    threadInfo->seed = seed;
+    threadInfo->spinLimit = LB_SPIN_MIN;
+    threadInfo->purgePriority = INFINITY;
+    pthread_cond_init(&threadInfo->threadWait, NULL);
+    pthread_mutex_init(&threadInfo->threadWaitLock, NULL);
+    threadInfo->nPops = 0;
+    threadInfo->rankError = 0;
+    threadInfo->nParks = 0;
+    threadInfo->nWakes = 0;
+    threadInfo->nPurged = 0;
+    threadInfo->idleTime = 0;
+    threadInfo->wakeTime = 0;
+    threadInfo->wakeLatency = 0;
+    return threadInfo;
+}
+
+void threadInfoDestroy(threadInfo_t* threadInfo) {
+    pthread_mutex_destroy(&threadInfo->threadWaitLock);
+    pthread_cond_destroy(&threadInfo->threadWait);
+    free(threadInfo);
+}
+
+struct _tspLoadBalancer {
+    CACHE_ALIGNED int nIdleThreads;
+    CACHE_ALIGNED int nParkedThreads;
+    CACHE_ALIGNED bool terminated;
+    int nThreads;
+    int nQueues;
+    double startTime;
+    threadInfo_t** threads;
+    queueInfo_t** queues;
+};
+
+#ifdef __STATS__
+static void _logStats(tspLoadBalancer_t* tspLoadBalancer) {
+    double execTime = omp_get_wtime() - tspLoadBalancer->startTime;
+    unsigned long nPops = 0, rankError = 0, nParks = 0, nWakes = 0, nPurged = 0;
+    double idleTime = 0, wakeLatency = 0;
+    for (int i = 0; i < tspLoadBalancer->nThreads; i++) {
+        threadInfo_t* thread = tspLoadBalancer->threads[i];
+        nPops += thread->nPops;
+        rankError += thread->rankError;
+        nParks += thread->nParks;
+        nWakes += thread->nWakes;
+        nPurged += thread->nPurged;
+        idleTime += thread->idleTime;
+        wakeLatency += thread->wakeLatency;
+    }
+    STATS_LOG("popped nodes = %lu", nPops);
+    STATS_LOG("average rank error = %.3f", (nPops > 0 ? (double)rankError / nPops : 0.0));
+    STATS_LOG("idle time = %.3fs (%.1f%%)", idleTime, 100 * idleTime / (execTime * tspLoadBalancer->nThreads));
+    STATS_LOG("parks = %lu", nParks);
+    STATS_LOG("average wake latency = %.1fus", (nWakes > 0 ? 1e6 * wakeLatency / nWakes : 0.0));
+    STATS_LOG("purged nodes = %lu (%.1f MB)", nPurged,
+              nPurged * (sizeof(tspNode_t) + sizeof(void*)) / (1024.0 * 1024.0));
+}
+
+// counts the queues holding a better node than the popped one (a lower bound of its rank error)
+static void _measureRankError(tspLoadBalancer_t* tspLoadBalancer, threadInfo_t* thread, const tspNode_t* node) {
+    thread->nPops++;
+    for (int i = 0; i < tspLoadBalancer->nQueues; i++) {
+        double topPriority;
+        __atomic_load(&tspLoadBalancer->queues[i]->topPriority, &topPriority, __ATOMIC_RELAXED);
+        if (topPriority < node->priority)
+            thread->rankError++;
+    }
+}
+#endif
+
+tspLoadBalancer_t* tspLoadBalancerCreate(int nThreads) {
+    tspLoadBalancer_t* loadBalancer = NULL;
+    posix_memalign((void**)&loadBalancer, CACHE_LINE_SIZE, sizeof(tspLoadBalancer_t));
+    loadBalancer->threads = (threadInfo_t**)calloc(nThreads, sizeof(threadInfo_t*));
+    loadBalancer->queues = (queueInfo_t**)calloc(nThreads * LB_QUEUES_PER_THREAD, sizeof(queueInfo_t*));
+    loadBalancer->nIdleThreads = 0;
+    loadBalancer->nParkedThreads = 0;
+    loadBalancer->terminated = false;
+    loadBalancer->nThreads = nThreads;
+    loadBalancer->nQueues = nThreads * LB_QUEUES_PER_THREAD;
+    loadBalancer->startTime = omp_get_wtime();
+    return loadBalancer;
+}
+
+void tspLoadBalancerDestroy(tspLoadBalancer_t* tspLoadBalancer) {
+    STATS(_logStats(tspLoadBalancer));
+    for (int i = 0; i < tspLoadBalancer->nThreads; i++)
+        threadInfoDestroy(tspLoadBalancer->threads[i]);
+    for (int i = 0; i < tspLoadBalancer->nQueues; i++)
+        queueInfoDestroy(tspLoadBalancer->queues[i]);
+    free(tspLoadBalancer->queues);
+    free(tspLoadBalancer->threads);
+    free(tspLoadBalancer);
+}
+
+void tspLoadBalancerInitThread(tspLoadBalancer_t* tspLoadBalancer) {
+    int threadNum = omp_get_thread_num();
+    tspLoadBalancer->threads[threadNum] = threadInfoCreate(threadNum + 1);
+    for (int i = 0; i < LB_QUEUES_PER_THREAD; i++)
+        tspLoadBalancer->queues[threadNum * LB_QUEUES_PER_THREAD + i] = queueInfoCreate();
+}
+
+static inline double _topPriority(queueInfo_t* queueInfo) {
+    double topPriority;
+    __atomic_load(&queueInfo->topPriority, &topPriority, __ATOMIC_RELAXED);
+    return topPriority;
+}
+
+static void _updateTopPriority(queueInfo_t* queueInfo) {
+    double topPriority = INFINITY;
+    if (queueSize(queueInfo->queue) > 0)
+        topPriority = ((tspNode_t*)queuePeek(queueInfo->queue))->priority;
+    __atomic_store(&queueInfo->topPriority, &topPriority, __ATOMIC_RELAXED);
+}
+
+static tspNode_t* _getNextNode(queueInfo_t* queueInfo, double solutionPriority) {
+    tspNode_t* node = queuePop(queueInfo->queue);
+    _updateTopPriority(queueInfo);
+    if (node != NULL && node->priority > solutionPriority) {
+        tspNodeDestroy(node);
+        return NULL;
+    }
+    return node;
+}
+
+static tspNode_t* _popQueue(queueInfo_t* queueInfo, double solutionPriority) {
+    omp_set_lock(&queueInfo->queueLock);
+    tspNode_t* node = _getNextNode(queueInfo, solutionPriority);
+    omp_unset_lock(&queueInfo->queueLock);
+    return node;
+}
+
+static void _pushQueue(queueInfo_t* queueInfo, tspNode_t** nodes, int nNodes) {
+    omp_set_lock(&queueInfo->queueLock);
+    for (int i = 0; i < nNodes; i++)
+        queuePush(queueInfo->queue, nodes[i]);
+    _updateTopPriority(queueInfo);
+    omp_unset_lock(&queueInfo->queueLock);
+}
+
+#ifdef __MULTIQUEUE__
+static tspNode_t* _popNode(tspLoadBalancer_t* tspLoadBalancer, threadInfo_t* thread, double solutionPriority) {
+    int nQueues = tspLoadBalancer->nQueues;
+    for (int i = 0; i < LB_MULTIQUEUE_RETRIES; i++) {
+        queueInfo_t* queue1 = tspLoadBalancer->queues[rand_r(&thread->seed) % nQueues];
+        queueInfo_t* queue2 = tspLoadBalancer->queues[rand_r(&thread->seed) % nQueues];
+        queueInfo_t* queueInfo = (_topPriority(queue2) < _topPriority(queue1) ? queue2 : queue1);
+        if (_topPriority(queueInfo) == INFINITY || !omp_test_lock(&queueInfo->queueLock))
+            continue;
+
+        tspNode_t* node = _getNextNode(queueInfo, solutionPriority);
+        omp_unset_lock(&queueInfo->queueLock);
+        if (node != NULL)
+            return node;
+    }
+
+    // the two-choice sampling keeps missing, so every queue is checked before the thread stops
+    int firstQueue = rand_r(&thread->seed) % nQueues;
+    for (int i = 0; i < nQueues; i++) {
+        tspNode_t* node = _popQueue(tspLoadBalancer->queues[(firstQueue + i) % nQueues], solutionPriority);
+        if (node != NULL)
+            return node;
+    }
+    return NULL;
+}
+
+// the best node stays in one of the local queues, the others are grouped by their random destination
+static void _pushNodes(tspLoadBalancer_t* tspLoadBalancer, threadInfo_t* thread, tspNode_t** nodes, int nNodes) {
+    int localQueue = omp_get_thread_num() * LB_QUEUES_PER_THREAD + rand_r(&thread->seed) % LB_QUEUES_PER_THREAD;
+    _pushQueue(tspLoadBalancer->queues[localQueue], nodes, 1);
+    if (nNodes == 1)
+        return;
+
+    int destinations[MAX_CITIES];
+    for (int i = 1; i < nNodes; i++)
+        destinations[i] = rand_r(&thread->seed) % tspLoadBalancer->nQueues;
+
+    tspNode_t* group[MAX_CITIES];
+    for (int i = 1; i < nNodes; i++) {
+        if (destinations[i] < 0)
+            continue;
+
+        int nGroup = 0;
+        for (int j = i; j < nNodes; j++) {
+            if (destinations[j] == destinations[i]) {
+                group[nGroup++] = nodes[j];
+                if (j != i)
+                    destinations[j] = -1;
+            }
+        }
+        _pushQueue(tspLoadBalancer->queues[destinations[i]], group, nGroup);
+    }
+}
+#else
+static int _stealNodes(queueInfo_t* victim, tspNode_t** nodes, double solutionPriority) {
+    int nNodes = 0;
+    omp_set_lock(&victim->queueLock);
+    int batchSize = (queueSize(victim->queue) + 1) / 2;
+    if (batchSize > LB_STEAL_BATCH)
+        batchSize = LB_STEAL_BATCH;
+    while (nNodes < batchSize) {
+        tspNode_t* node = _getNextNode(victim, solutionPriority);
+        if (node == NULL)
+            break;
+        nodes[nNodes++] = node;
+    }
+    omp_unset_lock(&victim->queueLock);
+    return nNodes;
+}
+
+static tspNode_t* _steal(tspLoadBalancer_t* tspLoadBalancer, threadInfo_t* thread, queueInfo_t* queueInfo,
+                         double solutionPriority) {
+    int nQueues = tspLoadBalancer->nQueues;
+    int firstVictim = rand_r(&thread->seed) % nQueues;
+    tspNode_t* nodes[LB_STEAL_BATCH];
+
+    for (int i = 0; i < nQueues; i++) {
+        queueInfo_t* victim = tspLoadBalancer->queues[(firstVictim + i) % nQueues];
+        if (victim == queueInfo)
+            continue;
+
+        int nNodes = _stealNodes(victim, nodes, solutionPriority);
+        if (nNodes == 0)
+            continue;
+
+        omp_set_lock(&queueInfo->queueLock);
+        for (int j = 1; j < nNodes; j++)
+            queuePush(queueInfo->queue, nodes[j]);
+        _updateTopPriority(queueInfo);
+        omp_unset_lock(&queueInfo->queueLock);
+        return nodes[0];
+    }
+
+    return NULL;
+}
+
+static tspNode_t* _popNode(tspLoadBalancer_t* tspLoadBalancer, threadInfo_t* thread, double solutionPriority) {
+    queueInfo_t* queueInfo = tspLoadBalancer->queues[omp_get_thread_num()];
+    tspNode_t* node = _popQueue(queueInfo, solutionPriority);
+    if (node == NULL)
+        node = _steal(tspLoadBalancer, thread, queueInfo, solutionPriority);
+    return node;
+}
+
+static void _pushNodes(tspLoadBalancer_t* tspLoadBalancer, threadInfo_t* thread, tspNode_t** nodes, int nNodes) {
+    (void)thread;
+    _pushQueue(tspLoadBalancer->queues[omp_get_thread_num()], nodes, nNodes);
+}
+#endif
+
+static void _purgeQueue(queueInfo_t* queueInfo, threadInfo_t* thread, double solutionPriority) {
+    omp_set_lock(&queueInfo->queueLock);
+    if (queueSize(queueInfo->queue) >= LB_PURGE_MIN_NODES) {
+        thread->nPurged +=
+            queueFilter(queueInfo->queue, __tspNodeIsPromisingFun, &solutionPriority, __tspNodeDestroyFun);
+        _updateTopPriority(queueInfo);
+    }
+    omp_unset_lock(&queueInfo->queueLock);
+}
+
+// pruned nodes are otherwise only dropped once popped, so each thread compacts its own queues after large enough
+// improvements of the incumbent
+static void _purgeQueues(tspLoadBalancer_t* tspLoadBalancer, threadInfo_t* thread, double solutionPriority) {
+    if (thread->purgePriority == INFINITY)
+        thread->purgePriority = solutionPriority;
+    if (solutionPriority > thread->purgePriority * (1 - LB_PURGE_MIN_IMPROVEMENT))
+        return;
+
+    int firstQueue = omp_get_thread_num() * LB_QUEUES_PER_THREAD;
+    for (int i = 0; i < LB_QUEUES_PER_THREAD; i++)
+        _purgeQueue(tspLoadBalancer->queues[firstQueue + i], thread, solutionPriority);
+    thread->purgePriority = solutionPriority;
+}
+
+static bool _unpark(tspLoadBalancer_t* tspLoadBalancer, threadInfo_t* thread) {
+    bool parked = true;
+    if (!__atomic_compare_exchange_n(&thread->parked, &parked, false, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return false;
+
+    __atomic_sub_fetch(&tspLoadBalancer->nParkedThreads, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&thread->threadWaitLock);
+    STATS(thread->wakeTime = omp_get_wtime());
+    pthread_cond_signal(&thread->threadWait);
+    pthread_mutex_unlock(&thread->threadWaitLock);
+    return true;
+}
+
+static void _wakeThread(tspLoadBalancer_t* tspLoadBalancer) {
+    for (int i = 0; i < tspLoadBalancer->nThreads; i++)
+        if (_unpark(tspLoadBalancer, tspLoadBalancer->threads[i]))
+            return;
+}
+
+static void _terminate(tspLoadBalancer_t* tspLoadBalancer) {
+    __atomic_store_n(&tspLoadBalancer->terminated, true, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < tspLoadBalancer->nThreads; i++)
+        _unpark(tspLoadBalancer, tspLoadBalancer->threads[i]);
+}
+
+static inline bool _isTerminated(tspLoadBalancer_t* tspLoadBalancer) {
+    return __atomic_load_n(&tspLoadBalancer->terminated, __ATOMIC_SEQ_CST);
+}
+
+static bool _hasWork(tspLoadBalancer_t* tspLoadBalancer, double solutionPriority) {
+    for (int i = 0; i < tspLoadBalancer->nQueues; i++)
+        if (_topPriority(tspLoadBalancer->queues[i]) <= solutionPriority)
+            return true;
+    return false;
+}
+
+// the spin budget grows while work keeps showing up during the spin and shrinks every time the thread parks
+static bool _spin(tspLoadBalancer_t* tspLoadBalancer, threadInfo_t* thread, double solutionPriority) {
+    for (int i = 0; i < thread->spinLimit && !_isTerminated(tspLoadBalancer); i++) {
+        if (_hasWork(tspLoadBalancer, solutionPriority)) {
+            if (thread->spinLimit < LB_SPIN_MAX)
+                thread->spinLimit *= 2;
+            return true;
+        }
+        sched_yield();
+    }
+
+    if (thread->spinLimit > LB_SPIN_MIN)
+        thread->spinLimit /= 2;
+    return false;
+}
+
+// the parked flag is raised before the last check, so a concurrent push or termination always sees it
+static void _park(tspLoadBalancer_t* tspLoadBalancer, threadInfo_t* thread, double solutionPriority) {
+    __atomic_store_n(&thread->parked, true, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&tspLoadBalancer->nParkedThreads, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (_isTerminated(tspLoadBalancer) || _hasWork(tspLoadBalancer, solutionPriority)) {
+        if (__atomic_exchange_n(&thread->parked, false, __ATOMIC_SEQ_CST))
+            __atomic_sub_fetch(&tspLoadBalancer->nParkedThreads, 1, __ATOMIC_SEQ_CST);
+        return;
+    }
+
+    STATS(thread->nParks++);
+    pthread_mutex_lock(&thread->threadWaitLock);
+    while (__atomic_load_n(&thread->parked, __ATOMIC_SEQ_CST))
+        pthread_cond_wait(&thread->threadWait, &thread->threadWaitLock);
+    STATS(thread->nWakes++);
+    STATS(thread->wakeLatency += omp_get_wtime() - thread->wakeTime);
+    pthread_mutex_unlock(&thread->threadWaitLock);
+}
+
+static void _enterIdle(tspLoadBalancer_t* tspLoadBalancer) {
+    if (__atomic_add_fetch(&tspLoadBalancer->nIdleThreads, 1, __ATOMIC_SEQ_CST) == tspLoadBalancer->nThreads)
+        _terminate(tspLoadBalancer);
+}
+
+// an idle thread holds no node and has found every queue empty (or pruned) after its last push, so the search is
+// over once all threads are idle at the same time
+static tspNode_t* _idle(tspLoadBalancer_t* tspLoadBalancer, threadInfo_t* thread, double solutionPriority) {
+    STATS(double idleStart = omp_get_wtime());
+    tspNode_t* node = NULL;
+
+    tspNodePoolFlush();
+    _enterIdle(tspLoadBalancer);
+    while (!_isTerminated(tspLoadBalancer)) {
+        if (!_spin(tspLoadBalancer, thread, solutionPriority)) {
+            _park(tspLoadBalancer, thread, solutionPriority);
+            continue;
+        }
+
+        __atomic_sub_fetch(&tspLoadBalancer->nIdleThreads, 1, __ATOMIC_SEQ_CST);
+        node = _popNode(tspLoadBalancer, thread, solutionPriority);
+        if (node != NULL)
+            break;
+        _enterIdle(tspLoadBalancer);
+    }
+
+    STATS(thread->idleTime += omp_get_wtime() - idleStart);
+    return node;
+}
+
+tspNode_t* tspLoadBalancerPop(tspLoadBalancer_t* tspLoadBalancer, double solutionPriority) {
+    threadInfo_t* thread = tspLoadBalancer->threads[omp_get_thread_num()];
+    _purgeQueues(tspLoadBalancer, thread, solutionPriority);
+    tspNode_t* node = _popNode(tspLoadBalancer, thread, solutionPriority);
+    if (node == NULL)
+        node = _idle(tspLoadBalancer, thread, solutionPriority);
+
+    STATS(if (node != NULL) _measureRankError(tspLoadBalancer, thread, node));
+    return node;
+}
+
+// never blocks nor counts the caller as idle, so the thread that talks to the other ranks keeps polling
+tspNode_t* tspLoadBalancerTryPop(tspLoadBalancer_t* tspLoadBalancer, double solutionPriority) {
+    threadInfo_t* thread = tspLoadBalancer->threads[omp_get_thread_num()];
+    _purgeQueues(tspLoadBalancer, thread, solutionPriority);
+    tspNode_t* node = _popNode(tspLoadBalancer, thread, solutionPriority);
+    if (node == NULL)
+        tspNodePoolFlush();
+    STATS(if (node != NULL) _measureRankError(tspLoadBalancer, thread, node));
+    return node;
+}
+
+tspNode_t* tspLoadBalancerPush(tspLoadBalancer_t* tspLoadBalancer, tspNode_t* node) {
+    tspLoadBalancerPushBatch(tspLoadBalancer, &node, 1);
+    return node;
+}
+
+void tspLoadBalancerPushBatch(tspLoadBalancer_t* tspLoadBalancer, tspNode_t** nodes, int nNodes) {
+    if (nNodes == 0)
+        return;
+
+    threadInfo_t* thread = tspLoadBalancer->threads[omp_get_thread_num()];
+    _pushNodes(tspLoadBalancer, thread, nodes, nNodes);
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&tspLoadBalancer->nParkedThreads, __ATOMIC_SEQ_CST) > 0)
+        _wakeThread(tspLoadBalancer);
+}
+
+// only meaningful for the polling thread after a failed pop, when every other thread is idle the rank has no work
+// the idle threads are counted before the queues are read, so no thread can push a node in between
+bool tspLoadBalancerIsIdle(tspLoadBalancer_t* tspLoadBalancer, double solutionPriority) {
+    return __atomic_load_n(&tspLoadBalancer->nIdleThreads, __ATOMIC_SEQ_CST) == tspLoadBalancer->nThreads - 1 &&
+           !_hasWork(tspLoadBalancer, solutionPriority);
+}
+
+void tspLoadBalancerTerminate(tspLoadBalancer_t* tspLoadBalancer) { _terminate(tspLoadBalancer); }
+
+bool tspLoadBalancerIsTerminated(tspLoadBalancer_t* tspLoadBalancer) { return _isTerminated(tspLoadBalancer); }
+
+// copies the best node of a random queue, so a helper thread can look at the frontier without taking work from it
+bool tspLoadBalancerSample(tspLoadBalancer_t* tspLoadBalancer, unsigned int* seed, tspNode_t* node) {
+    queueInfo_t* queueInfo = tspLoadBalancer->queues[rand_r(seed) % tspLoadBalancer->nQueues];
+    if (_topPriority(queueInfo) == INFINITY || !omp_test_lock(&queueInfo->queueLock))
+        return false;
+
+    bool found = (queueSize(queueInfo->queue) > 0);
+    if (found)
+        *node = *(tspNode_t*)queuePeek(queueInfo->queue);
+    omp_unset_lock(&queueInfo->queueLock);
+    return found;
+}
@@ -0,0 +1,24 @@
+#ifndef __TSP__TSP_LOAD_BALANCER_H__
+#define __TSP__TSP_LOAD_BALANCER_H__
+
+#include "include.h"
+#include "tspNode.h"
+
+typedef struct _tspLoadBalancer tspLoadBalancer_t;
+
+tspLoadBalancer_t* tspLoadBalancerCreate(int nThreads);
+void tspLoadBalancerDestroy(tspLoadBalancer_t* tspLoadBalancer);
+void tspLoadBalancerInitThread(tspLoadBalancer_t* tspLoadBalancer);
+
+tspNode_t* tspLoadBalancerPop(tspLoadBalancer_t* tspLoadBalancer, double solutionPriority);
+tspNode_t* tspLoadBalancerTryPop(tspLoadBalancer_t* tspLoadBalancer, double solutionPriority);
+tspNode_t* tspLoadBalancerPush(tspLoadBalancer_t* tspLoadBalancer, tspNode_t* node);
+void tspLoadBalancerPushBatch(tspLoadBalancer_t* tspLoadBalancer, tspNode_t** nodes, int nNodes);
+
+bool tspLoadBalancerIsIdle(tspLoadBalancer_t* tspLoadBalancer, double solutionPriority);
+bool tspLoadBalancerIsTerminated(tspLoadBalancer_t* tspLoadBalancer);
+void tspLoadBalancerTerminate(tspLoadBalancer_t* tspLoadBalancer);
+
+bool tspLoadBalancerSample(tspLoadBalancer_t* tspLoadBalancer, unsigned int* seed, tspNode_t* node);
+
+#endif // __TSP__TSP_LOAD_BALANCER_H__
@@ -0,0 +1,385 @@
+#include "tspSolver.h"
+#include "tspCluster.h"
+#include "tspHeuristic.h"
+#include "tspIncumbent.h"
+#include "tspLoadBalancer.h"
+#include "tspNode.h"
+#include "tspNodePool.h"
+#include "utils/queue.h"
+#include <math.h>
+#include <omp.h>
+#include <sched.h>
+
+#define SOLVER_RAMP_UP_NODES 64
+#define SOLVER_POLL_INTERVAL 64
+
+#ifdef __PRIMAL_HEURISTIC__
+#define SOLVER_HEURISTIC_THREADS 1
+#else
+#define SOLVER_HEURISTIC_THREADS 0
+#endif
+
+typedef struct {
+    const tsp_t* tsp;
+    tspApi_t* api;
+    tspCluster_t* cluster;
+    tspIncumbent_t* incumbent;
+    tspLoadBalancer_t* loadBalancer;
+    tspNodePool_t* nodePool;
+    int nThreads;
+    unsigned long nExpanded;
+    unsigned long nCreated;
+    unsigned long nHeuristicTours;
+    unsigned long nHeuristicImprovements;
+} tspSolverData_t;
+
+tspSolution_t* tspSolutionCreate(double maxTourCost) {
+    tspSolution_t* solution = (tspSolution_t*)malloc(sizeof(tspSolution_t));
+    solution->hasSolution = false;
+    solution->cost = maxTourCost;
+    solution->priority = maxTourCost * MAX_CITIES + MAX_CITIES - 1;
+    return solution;
+}
+
+void tspSolutionDestroy(tspSolution_t* solution) { free(solution); }
+
+static inline bool _isCityInTour(const tspNode_t* node, int cityNumber) {
+    return node->visited & (0x00000001 << cityNumber);
+}
+
+static inline bool _isCanonicalOrientation(const tsp_t* tsp, const tspNode_t* parent, int nextCity) {
+#ifdef __SYMMETRY_BREAKING__
+    // keeps the orientation whose last city is lower than the first, i.e. the one with the lower priority
+    if (parent->length + 1 >= tsp->nCities)
+        return true;
+    int firstCity = (parent->length == 1 ? nextCity : parent->tour[1]);
+    unsigned long long visited = parent->visited | (1ULL << nextCity);
+    return (~visited & ((1ULL << firstCity) - 1)) != 0;
+#else
+    (void)tsp;
+    (void)parent;
+    (void)nextCity;
+    return true;
+#endif
+}
+
+static double _calculateInitialLb(const tsp_t* tsp) {
+    double sum = 0.0;
+    for (int i = 0; i < tsp->nCities; i++)
+        sum += tspMinCost(tsp, i, TSP_MIN_COSTS_1) + tspMinCost(tsp, i, TSP_MIN_COSTS_2);
+    return sum / 2;
+}
+
+static double _calculateLb(const tsp_t* tsp, const tspNode_t* node, int nextCity) {
+    int currentCity = tspNodeCurrentCity(node);
+    double min1From = tspMinCost(tsp, currentCity, TSP_MIN_COSTS_1);
+    double min2From = tspMinCost(tsp, currentCity, TSP_MIN_COSTS_2);
+    double min1To = tspMinCost(tsp, nextCity, TSP_MIN_COSTS_1);
+    double min2To = tspMinCost(tsp, nextCity, TSP_MIN_COSTS_2);
+    double costFromTo = tsp->roadCosts[currentCity][nextCity];
+    double costFrom = (costFromTo >= min2From) ? min2From : min1From;
+    double costTo = (costFromTo >= min2To) ? min2To : min1To;
+    return node->lb + costFromTo - (costFrom + costTo) / 2;
+}
+
+static bool _updateBestTour(tspSolverData_t* solverData, const tspNode_t* finalNode) {
+    const tsp_t* tsp = solverData->tsp;
+    int currentCity = tspNodeCurrentCity(finalNode);
+    double cost = finalNode->cost + tsp->roadCosts[currentCity][0];
+    double priority = cost * MAX_CITIES + currentCity;
+    if (!tspIncumbentUpdate(solverData->incumbent, finalNode, cost, priority))
+        return false;
+    tspClusterNotifySolution(solverData->cluster);
+    return true;
+}
+
+// the children are staged sorted by priority, so that they can be handed over at once
+static int _expandNode(tspSolverData_t* solverData, const tspNode_t* parent, tspNode_t** children) {
+    const tsp_t* tsp = solverData->tsp;
+    int parentCurrentCity = tspNodeCurrentCity(parent);
+    double bestCost = tspIncumbentCost(solverData->incumbent);
+    int nChildren = 0;
+    for (int cityNumber = 0; cityNumber < tsp->nCities; cityNumber++) {
+        if (tspIsNeighbour(tsp, parentCurrentCity, cityNumber) && !_isCityInTour(parent, cityNumber) &&
+            _isCanonicalOrientation(tsp, parent, cityNumber)) {
+            double lb = _calculateLb(tsp, parent, cityNumber);
+            if (lb > bestCost)
+                continue;
+            double cost = parent->cost + tsp->roadCosts[parentCurrentCity][cityNumber];
+            tspNode_t* nextNode = tspNodeCreateExt(parent, cost, lb, cityNumber);
+            STATS(__atomic_fetch_add(&solverData->nCreated, 1, __ATOMIC_RELAXED));
+            int i = nChildren++;
+            for (; i > 0 && children[i - 1]->priority > nextNode->priority; i--)
+                children[i] = children[i - 1];
+            children[i] = nextNode;
+        }
+    }
+    return nChildren;
+}
+
+#ifdef __LAZY_EXPANSION__
+typedef struct {
+    int city;
+    double lb;
+    double priority;
+} tspChild_t;
+
+static int _sortedChildren(const tsp_t* tsp, const tspNode_t* parent, tspChild_t* children) {
+    int parentCurrentCity = tspNodeCurrentCity(parent);
+    int nChildren = 0;
+    for (int cityNumber = 0; cityNumber < tsp->nCities; cityNumber++) {
+        if (tspIsNeighbour(tsp, parentCurrentCity, cityNumber) && !_isCityInTour(parent, cityNumber) &&
+            _isCanonicalOrientation(tsp, parent, cityNumber)) {
+            double lb = _calculateLb(tsp, parent, cityNumber);
+            tspChild_t child = {cityNumber, lb, lb * MAX_CITIES + cityNumber};
+            int i = nChildren++;
+            for (; i > 0 && children[i - 1].priority > child.priority; i--)
+                children[i] = children[i - 1];
+            children[i] = child;
+        }
+    }
+    return nChildren;
+}
+
+static int _nextSibling(const tspChild_t* children, int nChildren, int sibling, double bestCost) {
+    while (sibling < nChildren && children[sibling].lb > bestCost)
+        sibling++;
+    return sibling;
+}
+
+// only the best pending child is created, the parent is pushed back as a cursor to its next sibling
+static bool _visitNeighbors(tspSolverData_t* solverData, tspNode_t* parent) {
+    const tsp_t* tsp = solverData->tsp;
+    int parentCurrentCity = tspNodeCurrentCity(parent);
+    tspChild_t children[MAX_CITIES];
+    int nChildren = _sortedChildren(tsp, parent, children);
+    double bestCost = tspIncumbentCost(solverData->incumbent);
+
+    int sibling = _nextSibling(children, nChildren, parent->sibling, bestCost);
+    if (sibling == nChildren)
+        return false;
+
+    const tspChild_t* child = &children[sibling];
+    double cost = parent->cost + tsp->roadCosts[parentCurrentCity][child->city];
+    tspNode_t* nodes[2] = {tspNodeCreateExt(parent, cost, child->lb, child->city), parent};
+    STATS(__atomic_fetch_add(&solverData->nCreated, 1, __ATOMIC_RELAXED));
+
+    sibling = _nextSibling(children, nChildren, sibling + 1, bestCost);
+    if (sibling == nChildren) {
+        tspLoadBalancerPushBatch(solverData->loadBalancer, nodes, 1);
+        return false;
+    }
+
+    parent->sibling = sibling;
+    parent->priority = children[sibling].priority;
+    tspLoadBalancerPushBatch(solverData->loadBalancer, nodes, 2);
+    return true;
+}
+#else
+static bool _visitNeighbors(tspSolverData_t* solverData, tspNode_t* parent) {
+    tspNode_t* children[MAX_CITIES];
+    int nChildren = _expandNode(solverData, parent, children);
+    tspLoadBalancerPushBatch(solverData->loadBalancer, children, nChildren);
+    return false;
+}
+#endif
+
+static bool _processNode(tspSolverData_t* solverData, tspNode_t* node) {
+    const tsp_t* tsp = solverData->tsp;
+    STATS(__atomic_fetch_add(&solverData->nExpanded, 1, __ATOMIC_RELAXED));
+    if ((node->length == tsp->nCities) && tspIsNeighbour(tsp, tspNodeCurrentCity(node), 0)) {
+        _updateBestTour(solverData, node);
+        return false;
+    }
+    return _visitNeighbors(solverData, node);
+}
+
+static int __tspNodeCmpFun(void* el1, void* el2) {
+    tspNode_t* node1 = (tspNode_t*)el1;
+    tspNode_t* node2 = (tspNode_t*)el2;
+    return (node2->priority < node1->priority ? 1 : 0);
+}
+
+static void __tspNodeDestroyFun(void* el) {
+    tspNode_t* node = (tspNode_t*)el;
+    tspNodeDestroy(node);
+}
+
+static int __tspNodeBreadthFirstCmpFun(void* el1, void* el2) {
+    tspNode_t* node1 = (tspNode_t*)el1;
+    tspNode_t* node2 = (tspNode_t*)el2;
+    if (node1->length != node2->length)
+        return (node2->length < node1->length ? 1 : 0);
+    return (node2->priority < node1->priority ? 1 : 0);
+}
+
+// the sorted frontier is dealt in a snake order (0, 1, .., n-1, n-1, .., 0, 0, ..), which balances the bounds
+static inline int _frontierOwner(int index, int nProcs) {
+    int round = index % (2 * nProcs);
+    return (round < nProcs ? round : 2 * nProcs - 1 - round);
+}
+
+// every rank expands the same breadth-first frontier and keeps its own share of it, so no nodes are sent at start-up
+static void _rampUp(tspSolverData_t* solverData) {
+    const tsp_t* tsp = solverData->tsp;
+    tspApi_t* api = solverData->api;
+    priorityQueue_t* frontier = queueCreate(__tspNodeBreadthFirstCmpFun);
+    queuePush(frontier, tspNodeCreate(0, _calculateInitialLb(tsp), 1, 0));
+
+    while (queueSize(frontier) > 0 && queueSize(frontier) < (size_t)(SOLVER_RAMP_UP_NODES * api->nProcs)) {
+        tspNode_t* node = queuePop(frontier);
+        if (node->priority > tspIncumbentPriority(solverData->incumbent)) {
+            tspNodeDestroy(node);
+            continue;
+        }
+
+        if (node->length == tsp->nCities) {
+            if (tspIsNeighbour(tsp, tspNodeCurrentCity(node), 0))
+                _updateBestTour(solverData, node);
+        } else {
+            tspNode_t* children[MAX_CITIES];
+            int nChildren = _expandNode(solverData, node, children);
+            for (int i = 0; i < nChildren; i++)
+                queuePush(frontier, children[i]);
+        }
+        tspNodeDestroy(node);
+    }
+
+    priorityQueue_t* sorted = queueCreate(__tspNodeCmpFun);
+    while (queueSize(frontier) > 0)
+        queuePush(sorted, queuePop(frontier));
+    for (int i = 0; queueSize(sorted) > 0; i++) {
+        tspNode_t* node = queuePop(sorted);
+        if (_frontierOwner(i, api->nProcs) == api->procId)
+            tspLoadBalancerPush(solverData->loadBalancer, node);
+        else
+            tspNodeDestroy(node);
+    }
+    queueDestroy(sorted, NULL);
+    queueDestroy(frontier, __tspNodeDestroyFun);
+}
+
+// the master thread is the only one polling the other ranks, it never parks while the cluster is still searching
+static void _masterLoop(tspSolverData_t* solverData) {
+    tspCluster_t* cluster = solverData->cluster;
+    unsigned long nProcessed = 0;
+
+    while (!tspClusterIsTerminated(cluster)) {
+        if (nProcessed++ % SOLVER_POLL_INTERVAL == 0)
+            tspClusterPoll(cluster);
+
+        tspNode_t* node = tspLoadBalancerTryPop(solverData->loadBalancer, tspIncumbentPriority(solverData->incumbent));
+        if (node != NULL) {
+            if (!_processNode(solverData, node))
+                tspNodeDestroy(node);
+            continue;
+        }
+
+        tspClusterPoll(cluster);
+        if (tspLoadBalancerIsIdle(solverData->loadBalancer, tspIncumbentPriority(solverData->incumbent)))
+            tspClusterRequestWork(cluster);
+        else
+            sched_yield();
+    }
+
+    tspLoadBalancerTerminate(solverData->loadBalancer);
+}
+
+static void _workerLoop(tspSolverData_t* solverData) {
+    while (true) {
+        tspNode_t* node = tspLoadBalancerPop(solverData->loadBalancer, tspIncumbentPriority(solverData->incumbent));
+        if (node == NULL)
+            break;
+        if (!_processNode(solverData, node))
+            tspNodeDestroy(node);
+    }
+}
+
+// the node is copied out of the frontier, so the heuristic thread never holds work the search threads wait for
+static void _heuristicLoop(tspSolverData_t* solverData) {
+    unsigned int seed = solverData->api->procId * omp_get_num_threads() + omp_get_thread_num() + 1;
+    tspNode_t node, finalNode;
+    double lastPriority = INFINITY;
+    unsigned long long lastVisited = 0;
+
+    while (!tspLoadBalancerIsTerminated(solverData->loadBalancer)) {
+        if (!tspLoadBalancerSample(solverData->loadBalancer, &seed, &node) ||
+            (node.priority == lastPriority && node.visited == lastVisited)) {
+            sched_yield();
+            continue;
+        }
+
+        lastPriority = node.priority;
+        lastVisited = node.visited;
+        if (!tspHeuristicTour(solverData->tsp, &node, &finalNode))
+            continue;
+        solverData->nHeuristicTours++;
+        solverData->nHeuristicImprovements += _updateBestTour(solverData, &finalNode);
+    }
+}
+
+#ifdef __STATS__
+static void _logStats(tspSolverData_t* solverData) {
+    unsigned long local[4] = {solverData->nExpanded, solverData->nCreated, solverData->nHeuristicTours,
+                              solverData->nHeuristicImprovements};
+    unsigned long total[4] = {0, 0, 0, 0};
+    MPI_Reduce(local, total, 4, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (solverData->api->procId == 0) {
+        STATS_LOG("expanded nodes = %lu", total[0]);
+        STATS_LOG("created nodes = %lu", total[1]);
+        if (total[2] > 0)
+            STATS_LOG("heuristic tours = %lu (%lu improvements)", total[2], total[3]);
+    }
+}
+#endif
+
+tspSolution_t* tspSolve(const tsp_t* tsp, double maxTourCost, int nThreads, const threadPlacement_t* placement,
+                        tspApi_t* api) {
+    tspSolverData_t solverData;
+
+#pragma omp parallel num_threads(nThreads)
+    {
+        threadPlacementPin(placement, omp_get_thread_num());
+
+#pragma omp single
+        {
+            solverData.tsp = tsp;
+            solverData.api = api;
+            // the master thread always searches, so a team of one has no heuristic thread
+            solverData.nThreads = omp_get_num_threads();
+            if (solverData.nThreads > SOLVER_HEURISTIC_THREADS)
+                solverData.nThreads -= SOLVER_HEURISTIC_THREADS;
+            solverData.incumbent = tspIncumbentCreate(maxTourCost, omp_get_num_threads());
+            solverData.loadBalancer = tspLoadBalancerCreate(solverData.nThreads);
+            solverData.nodePool = tspNodePoolCreate(omp_get_num_threads());
+            solverData.cluster = tspClusterCreate(api, solverData.incumbent, solverData.loadBalancer);
+            solverData.nExpanded = 0;
+            solverData.nCreated = 0;
+            solverData.nHeuristicTours = 0;
+            solverData.nHeuristicImprovements = 0;
+        }
+
+        if (omp_get_thread_num() < solverData.nThreads)
+            tspLoadBalancerInitThread(solverData.loadBalancer);
+        tspNodePoolInitThread(solverData.nodePool);
+#pragma omp barrier
+
+        if (omp_get_thread_num() == 0) {
+            _rampUp(&solverData);
+            _masterLoop(&solverData);
+        } else if (omp_get_thread_num() < solverData.nThreads) {
+            _workerLoop(&solverData);
+        } else {
+            _heuristicLoop(&solverData);
+        }
+        tspNodePoolFinishThread(solverData.nodePool);
+    }
+
+    tspSolution_t* solution = tspClusterSolution(solverData.cluster);
+    STATS(_logStats(&solverData));
+    tspClusterDestroy(solverData.cluster);
+    tspIncumbentDestroy(solverData.incumbent);
+    tspLoadBalancerDestroy(solverData.loadBalancer);
+    tspNodePoolDestroy(solverData.nodePool);
+    return solution;
+}
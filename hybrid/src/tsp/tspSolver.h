@@ -0,0 +1,21 @@
+#ifndef __TSP__TSP_SOLVER_H__
+#define __TSP__TSP_SOLVER_H__
+
+#include "include.h"
+#include "tsp.h"
+#include "tspApi.h"
+#include "utils/threads.h"
+
+typedef struct {
+    bool hasSolution;
+    double cost;
+    double priority;
+    char tour[MAX_CITIES];
+} tspSolution_t;
+
+tspSolution_t* tspSolutionCreate(double maxTourCost);
+void tspSolutionDestroy(tspSolution_t* tspSolution);
+tspSolution_t* tspSolve(const tsp_t* tsp, double maxTourCost, int nThreads, const threadPlacement_t* placement,
+                        tspApi_t* api);
+
+#endif // __TSP__TSP_SOLVER_H__
@@ -0,0 +1,26 @@
+#ifndef __UTILS__THREADS_H__
+#define __UTILS__THREADS_H__
+
+#include "include.h"
+
+#define THREAD_CGROUP_V2_MAX "/sys/fs/cgroup/cpu.max"
+#define THREAD_CGROUP_V1_QUOTA "/sys/fs/cgroup/cpu/cpu.cfs_quota_us"
+#define THREAD_CGROUP_V1_PERIOD "/sys/fs/cgroup/cpu/cpu.cfs_period_us"
+#define THREAD_CPU_PACKAGE "/sys/devices/system/cpu/cpu%d/topology/physical_package_id"
+
+typedef enum {
+    THREAD_POLICY_NONE,
+    THREAD_POLICY_COMPACT,
+    THREAD_POLICY_SCATTER,
+} threadPolicy_t;
+
+typedef struct _threadPlacement threadPlacement_t;
+
+int threadDefaultCount();
+bool threadParsePolicy(const char* name, threadPolicy_t* policy);
+
+threadPlacement_t* threadPlacementCreate(threadPolicy_t policy);
+void threadPlacementDestroy(threadPlacement_t* placement);
+void threadPlacementPin(const threadPlacement_t* placement, int threadNum);
+
+#endif // __UTILS__THREADS_H__
@@ -0,0 +1,65 @@
+#!/bin/bash
+
+if [ $# -lt 1 ] ; then
+	echo "Usage: ${0} <test_name> [max processes] [none|core] [oversubscribe]"
+	exit 1
+fi
+
+PATH_DIR=$(dirname $(realpath $0))
+PATH_TEST=${PATH_DIR}/../test
+PATH_OUT_1=${PATH_TEST}/out/base
+PATH_OUT_2=${PATH_TEST}/out/inverted
+PATH_RES=${PATH_DIR}/bin/res.txt
+PATH_STATS=${PATH_DIR}/bin/scaling
+
+IN=${1}
+MAX_PROCS=${2:-$(nproc)}
+BINDING=${3:-none}
+OVERSUBSCRIBE=${4:-}
+OUT_1=${PATH_OUT_1}/$(basename ${IN} .in).out
+OUT_2=${PATH_OUT_2}/$(basename ${IN} .in).out
+TEST=$(basename $IN)
+RUN=${PATH_DIR}/tsp-mpi
+MAX_VALUE=$(echo ${TEST} | sed -n "s/^.*-\([0-9]*\).*$/\1/p")
+
+# more ranks than cores can only be bound to a core when the cores are allowed to be overloaded
+MPIRUN_FLAGS="--bind-to ${BINDING}"
+if [ "${OVERSUBSCRIBE}" = "oversubscribe" ]; then
+	MPIRUN_FLAGS="--oversubscribe --bind-to ${BINDING}$([ ${BINDING} = core ] && echo :overload-allowed)"
+fi
+
+mkdir -p ${PATH_STATS}
+printf "\e[33m%s (binding = %s%s)\e[0m\n" ${TEST} ${BINDING} "${OVERSUBSCRIBE:+, ${OVERSUBSCRIBE}}"
+printf "%8s %10s %10s %10s %10s\n" "procs" "time" "solve" "speedup" "efficiency"
+
+BASE_TIME=""
+PROCS=1
+while [ ${PROCS} -le ${MAX_PROCS} ]; do
+	# the standard error keeps the solve time reported by rank 0, and the statistics of stats or profile builds
+	PATH_ERR=${PATH_STATS}/$(basename ${IN} .in)-np${PROCS}.txt
+	START=$(date +%s.%N)
+	mpirun ${MPIRUN_FLAGS} -np ${PROCS} ${RUN} ${IN} ${MAX_VALUE} 1> ${PATH_RES} 2> ${PATH_ERR}
+	END=$(date +%s.%N)
+	TIME=$(awk "BEGIN { print ${END} - ${START} }")
+	SOLVE_TIME=$(sed -n "s/^\([0-9.]*\)s$/\1/p" ${PATH_ERR} | tail -n 1)
+	BASE_TIME=${BASE_TIME:-${TIME}}
+
+	if diff ${PATH_RES} ${OUT_1} >/dev/null || diff ${PATH_RES} ${OUT_2} >/dev/null; then
+		STATUS="\e[32m[Succ]\e[0m"
+	else
+		STATUS="\e[31m[Fail]\e[0m"
+	fi
+
+	SPEEDUP=$(awk "BEGIN { print ${BASE_TIME} / ${TIME} }")
+	EFFICIENCY=$(awk "BEGIN { print ${SPEEDUP} / ${PROCS} }")
+	printf "%8d %9.2fs %9.1fs %10.2f %10.2f ${STATUS}\n" ${PROCS} ${TIME} ${SOLVE_TIME:-0} ${SPEEDUP} ${EFFICIENCY}
+
+	if [ ${PROCS} -lt ${MAX_PROCS} ] && [ $((PROCS * 2)) -gt ${MAX_PROCS} ]; then
+		PROCS=${MAX_PROCS}
+	else
+		PROCS=$((PROCS * 2))
+	fi
+done
+
+printf "\e[2mrank statistics: %s\e[0m\n" ${PATH_STATS}
+rm -f ${PATH_RES}
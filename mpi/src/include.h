@@ -7,6 +7,8 @@
 #include <string.h>
 
 #include "utils/debug.h"
+#include "utils/profile.h"
+#include "utils/stats.h"
 #include "utils/utils.h"
 
 #endif // __INCLUDE_H__
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "include.h"
+#include "tsp/tspApi.h"
+#include "tsp/tspInstance.h"
 #include "tsp/tspSolver.h"
 #include <omp.h>
 
@@ -30,6 +32,15 @@ tsp_t parseInput(const char* inPath) {
     return tsp;
 }
 
+#ifdef __STATS__
+void logStartupTime(const tspApi_t* api, double startupTime) {
+    double maxStartupTime = 0;
+    MPI_Reduce(&startupTime, &maxStartupTime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (api->procId == 0)
+        STATS_LOG("startup time = %.3fs (%d ranks)", maxStartupTime, api->nProcs);
+}
+#endif
+
 void printSolution(const tsp_t* tsp, const tspSolution_t* solution) {
     if (solution->hasSolution) {
         printf("%.1f\n", solution->cost);
@@ -48,21 +59,34 @@ int main(int argc, char* argv[]) {
     }
 
 
+    tspApi_t* api = tspApiCreate();
+    tspApiInit(api, &argc, &argv);
+
     const char* inPath = argv[1];
     double maxTourCost = atoi(argv[2]);
     LOG("inPath = %s", inPath);
     LOG("maxTourCost = %f", maxTourCost);
-    tsp_t tsp = parseInput(inPath);
+    STATS(double startupTime = -omp_get_wtime());
+    tsp_t tsp = {0, 0, NULL, NULL};
+    if (api->procId == 0)
+        tsp = parseInput(inPath);
+    tspInstance_t* instance = tspInstanceShare(api, &tsp);
+    STATS(startupTime += omp_get_wtime());
+    STATS(logStartupTime(api, startupTime));
     DEBUG(tspPrint(&tsp));
 
     double execTime = -omp_get_wtime();
-    tspSolution_t* solution = tspSolve(&tsp, maxTourCost);
+    tspSolution_t* solution = tspSolve(&tsp, maxTourCost, api);
     execTime += omp_get_wtime();
 
-    fprintf(stderr, "%.1fs\n", execTime);
-    printSolution(&tsp, solution);
+    if (api->procId == 0) {
+        fprintf(stderr, "%.1fs\n", execTime);
+        printSolution(&tsp, solution);
+    }
 
     tspSolutionDestroy(solution);
-    tspDestroy(&tsp);
+    tspInstanceDestroy(instance, &tsp);
+    tspApiTerminate(api);
+    tspApiDestroy(api);
     return 0;
 }
\ No newline at end of file
@@ -1,5 +1,4 @@
 #include "tspApi.h"
-#include "tspNode.h"
 #include "tspSolver.h"
 #include <stddef.h>
 
@@ -21,26 +20,6 @@ MPI_Datatype tspApiSolutionDatatype() {
     return newType;
 }
 
-MPI_Datatype tspApiNodeDatatype() {
-    MPI_Datatype newType;
-
-    const int nBlocks = 6;
-    const int blockLengths[] = {1, 1, 1, 1, MAX_CITIES, 1};
-    const MPI_Datatype blockTypes[] = {MPI_DOUBLE, MPI_DOUBLE, MPI_DOUBLE, MPI_INT, MPI_CHAR, MPI_UNSIGNED_LONG_LONG};
-
-    MPI_Aint blockDisplacements[nBlocks];
-    blockDisplacements[0] = (MPI_Aint)offsetof(tspNode_t, cost);
-    blockDisplacements[1] = (MPI_Aint)offsetof(tspNode_t, lb);
-    blockDisplacements[2] = (MPI_Aint)offsetof(tspNode_t, priority);
-    blockDisplacements[3] = (MPI_Aint)offsetof(tspNode_t, length);
-    blockDisplacements[4] = (MPI_Aint)offsetof(tspNode_t, tour);
-    blockDisplacements[5] = (MPI_Aint)offsetof(tspNode_t, visited);
-
-    MPI_Type_create_struct(nBlocks, blockLengths, blockDisplacements, blockTypes, &newType);
-    MPI_Type_commit(&newType);
-    return newType;
-}
-
 tspApi_t* tspApiCreate() {
     tspApi_t* api = (tspApi_t*)malloc(sizeof(tspApi_t));
     api->procId = -1;
@@ -50,18 +29,26 @@ tspApi_t* tspApiCreate() {
 
 void tspApiDestroy(tspApi_t* api) { free(api); }
 
-void tspApiInit(tspApi_t* api) {
-    MPI_Init(NULL, NULL);
+void tspApiInit(tspApi_t* api, int* argc, char*** argv) {
+    MPI_Init(argc, argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &api->procId);
     MPI_Comm_size(MPI_COMM_WORLD, &api->nProcs);
     api->procType = (api->procId == 0 ? PROCTYPE_MASTER : PROCTYPE_TASK);
+    // the ranks that share a host can also share memory
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, api->procId, MPI_INFO_NULL, &api->nodeComm);
+    MPI_Comm_size(api->nodeComm, &api->nodeSize);
+    MPI_Comm_rank(api->nodeComm, &api->nodeRank);
+    // the first rank of each node, with rank 0 first, receives the instance for the whole node
+    MPI_Comm_split(MPI_COMM_WORLD, (api->nodeRank == 0 ? 0 : MPI_UNDEFINED), api->procId, &api->leaderComm);
     api->solution_t = tspApiSolutionDatatype();
-    api->node_t = tspApiNodeDatatype();
 }
 
 void tspApiTerminate(tspApi_t* api) {
     api->procId = -1;
     api->nProcs = -1;
+    MPI_Comm_free(&api->nodeComm);
+    if (api->leaderComm != MPI_COMM_NULL)
+        MPI_Comm_free(&api->leaderComm);
     MPI_Barrier(MPI_COMM_WORLD);
     MPI_Finalize();
 }
\ No newline at end of file
@@ -13,26 +13,25 @@ typedef struct {
     int nProcs;
     int procId;
     tspApiProcType_t procType;
+    MPI_Comm nodeComm;
+    int nodeSize;
+    int nodeRank;
+    MPI_Comm leaderComm;
     MPI_Datatype solution_t;
-    MPI_Datatype node_t;
 } tspApi_t;
 
 tspApi_t* tspApiCreate();
 void tspApiDestroy(tspApi_t* api);
 
-void tspApiInit(tspApi_t* api);
+void tspApiInit(tspApi_t* api, int* argc, char*** argv);
 void tspApiTerminate(tspApi_t* api);
 
 #define MPI_TAG_NODE 100
-#define MPI_TAG_SOLUTION 101
-#define MPI_TAG_PSTATUS 102
+#define MPI_TAG_TOKEN 102
 #define MPI_TAG_TERMINATED 103
 #define MPI_TAG_INIT 104
 #define MPI_TAG_ASK_NODE 105
-#define MPI_TAG_TODO1 106
-#define MPI_TAG_TODO2 107
 
 MPI_Datatype tspApiSolutionDatatype();
-MPI_Datatype tspApiNodeDatatype();
 
 #endif //__TSP_TSP_API_H__
\ No newline at end of file
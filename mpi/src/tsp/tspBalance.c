@@ -0,0 +1,86 @@
+#include "tspBalance.h"
+#include <math.h>
+
+#define BALANCE_COUNT 2
+
+typedef struct {
+    double priority;
+    int procId;
+} tspBalanceEntry_t;
+
+// the first entry finds the rank with the best node and the second one, which holds the negated priorities, finds
+// the rank whose best node is the worst
+struct _tspBalance {
+    int procId;
+    MPI_Comm comm;
+    tspBalanceEntry_t local[BALANCE_COUNT];
+    tspBalanceEntry_t global[BALANCE_COUNT];
+    MPI_Request request;
+    unsigned long nRounds;
+    unsigned long nTransfers;
+};
+
+// the rounds run on their own communicator, so they never have to be matched with the other collectives
+tspBalance_t* tspBalanceCreate(const tspApi_t* api) {
+    tspBalance_t* balance = (tspBalance_t*)malloc(sizeof(tspBalance_t));
+    balance->procId = api->procId;
+    balance->request = MPI_REQUEST_NULL;
+    balance->nRounds = 0;
+    balance->nTransfers = 0;
+    MPI_Comm_dup(MPI_COMM_WORLD, &balance->comm);
+    return balance;
+}
+
+static void _startRound(tspBalance_t* balance, double priority) {
+    // a rank without nodes is never the best one nor the one that lags
+    balance->local[0].priority = priority;
+    balance->local[1].priority = (priority == INFINITY ? INFINITY : -priority);
+    balance->local[0].procId = balance->procId;
+    balance->local[1].procId = balance->procId;
+    MPI_Iallreduce(balance->local, balance->global, BALANCE_COUNT, MPI_DOUBLE_INT, MPI_MINLOC, balance->comm,
+                   &balance->request);
+    balance->nRounds++;
+}
+
+#ifdef __STATS__
+static void _logStats(tspBalance_t* balance) {
+    unsigned long nTransfers = 0;
+    MPI_Reduce(&balance->nTransfers, &nTransfers, 1, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (balance->procId == 0)
+        STATS_LOG("rebalancing rounds = %lu (%lu transfers)", balance->nRounds, nTransfers);
+}
+#endif
+
+// a round only completes once every rank started it, so the ranks are at most one round apart and the ones behind
+// start the last round before waiting for it
+void tspBalanceDestroy(tspBalance_t* balance) {
+    unsigned long nRounds = 0;
+    MPI_Allreduce(&balance->nRounds, &nRounds, 1, MPI_UNSIGNED_LONG, MPI_MAX, MPI_COMM_WORLD);
+    if (balance->nRounds < nRounds) {
+        MPI_Wait(&balance->request, MPI_STATUS_IGNORE);
+        _startRound(balance, INFINITY);
+    }
+    MPI_Wait(&balance->request, MPI_STATUS_IGNORE);
+    STATS(_logStats(balance));
+    MPI_Comm_free(&balance->comm);
+    free(balance);
+}
+
+// returns the rank this one should ask for nodes, when its best node lagged too far behind in the last round
+int tspBalancePoll(tspBalance_t* balance, double priority) {
+    int isComplete = true;
+    MPI_Test(&balance->request, &isComplete, MPI_STATUS_IGNORE);
+    if (!isComplete)
+        return -1;
+
+    int victim = -1;
+    const tspBalanceEntry_t* best = &balance->global[0];
+    const tspBalanceEntry_t* worst = &balance->global[1];
+    if (balance->nRounds > 0 && worst->procId == balance->procId && best->procId != balance->procId &&
+        -worst->priority > best->priority * (1 + BALANCE_MIN_GAP)) {
+        victim = best->procId;
+        STATS(balance->nTransfers++);
+    }
+    _startRound(balance, priority);
+    return victim;
+}
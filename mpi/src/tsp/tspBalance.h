@@ -0,0 +1,17 @@
+#ifndef __TSP__TSP_BALANCE_H__
+#define __TSP__TSP_BALANCE_H__
+
+#include "include.h"
+#include "tspApi.h"
+#include <mpi.h>
+
+#define BALANCE_MIN_GAP 0.01
+
+typedef struct _tspBalance tspBalance_t;
+
+tspBalance_t* tspBalanceCreate(const tspApi_t* api);
+void tspBalanceDestroy(tspBalance_t* balance);
+
+int tspBalancePoll(tspBalance_t* balance, double priority);
+
+#endif // __TSP__TSP_BALANCE_H__
@@ -0,0 +1,128 @@
+#include "tspBound.h"
+
+#define BOUND_COUNT 2
+
+struct _tspBound {
+    int procId;
+    bool isNodeLeader;
+    MPI_Win win;
+    tspBoundValue_t* value;
+    MPI_Win nodeWin;
+    tspBoundValue_t* nodeValue;
+    tspBoundValue_t readValue;
+    MPI_Request readRequest;
+    unsigned long nOffers;
+    unsigned long nReads;
+};
+
+// the best bound lives in a window on a single rank, which the other ranks read and lower with atomic operations,
+// and every host keeps a copy in shared memory so that only the first rank of a host has to read the window
+tspBound_t* tspBoundCreate(const tspApi_t* api, const tspBoundValue_t* value) {
+    tspBound_t* bound = (tspBound_t*)malloc(sizeof(tspBound_t));
+    bound->procId = api->procId;
+    bound->isNodeLeader = (api->nodeRank == 0);
+    bound->readRequest = MPI_REQUEST_NULL;
+    bound->nOffers = 0;
+    bound->nReads = 0;
+
+    MPI_Aint size = (api->procId == BOUND_OWNER ? sizeof(tspBoundValue_t) : 0);
+    MPI_Win_allocate(size, sizeof(double), MPI_INFO_NULL, MPI_COMM_WORLD, &bound->value, &bound->win);
+    if (api->procId == BOUND_OWNER)
+        *bound->value = *value;
+
+    MPI_Aint nodeSize = (bound->isNodeLeader ? sizeof(tspBoundValue_t) : 0);
+    MPI_Win_allocate_shared(nodeSize, sizeof(double), MPI_INFO_NULL, api->nodeComm, &bound->nodeValue, &bound->nodeWin);
+    if (bound->isNodeLeader) {
+        *bound->nodeValue = *value;
+    } else {
+        int dispUnit;
+        MPI_Win_shared_query(bound->nodeWin, 0, &nodeSize, &dispUnit, &bound->nodeValue);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, bound->win);
+    return bound;
+}
+
+#ifdef __STATS__
+static void _logStats(tspBound_t* bound) {
+    unsigned long local[2] = {bound->nOffers, bound->nReads};
+    unsigned long total[2] = {0, 0};
+    MPI_Reduce(local, total, 2, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (bound->procId == 0)
+        STATS_LOG("bound updates = %lu (%lu window reads)", total[0], total[1]);
+}
+#endif
+
+void tspBoundDestroy(tspBound_t* bound) {
+    MPI_Wait(&bound->readRequest, MPI_STATUS_IGNORE);
+    STATS(_logStats(bound));
+    MPI_Win_unlock_all(bound->win);
+    MPI_Win_free(&bound->win);
+    MPI_Win_free(&bound->nodeWin);
+    free(bound);
+}
+
+static bool _minValue(tspBoundValue_t* value, const tspBoundValue_t* otherValue) {
+    bool isLowered = false;
+    if (otherValue->cost < value->cost) {
+        value->cost = otherValue->cost;
+        isLowered = true;
+    }
+    if (otherValue->priority < value->priority) {
+        value->priority = otherValue->priority;
+        isLowered = true;
+    }
+    return isLowered;
+}
+
+static void _lowerShared(double* shared, double value) {
+    double sharedValue;
+    __atomic_load(shared, &sharedValue, __ATOMIC_RELAXED);
+    while (value < sharedValue &&
+           !__atomic_compare_exchange(shared, &sharedValue, &value, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+}
+
+static void _lowerNodeValue(tspBound_t* bound, const tspBoundValue_t* value) {
+    _lowerShared(&bound->nodeValue->cost, value->cost);
+    _lowerShared(&bound->nodeValue->priority, value->priority);
+}
+
+// the cost and the priority are lowered independently, the value is left with the best of both
+void tspBoundOffer(tspBound_t* bound, tspBoundValue_t* value) {
+    tspBoundValue_t oldValue;
+    _lowerNodeValue(bound, value);
+    MPI_Get_accumulate(value, BOUND_COUNT, MPI_DOUBLE, &oldValue, BOUND_COUNT, MPI_DOUBLE, BOUND_OWNER, 0, BOUND_COUNT,
+                       MPI_DOUBLE, MPI_MIN, bound->win);
+    MPI_Win_flush(BOUND_OWNER, bound->win);
+    STATS(bound->nOffers++);
+    if (_minValue(value, &oldValue))
+        _lowerNodeValue(bound, value);
+}
+
+// the window reads are non-blocking and only made by the first rank of a host, the others read the shared copy
+static void _pollWindow(tspBound_t* bound) {
+    if (bound->readRequest != MPI_REQUEST_NULL) {
+        int isDone;
+        MPI_Test(&bound->readRequest, &isDone, MPI_STATUS_IGNORE);
+        if (!isDone)
+            return;
+        STATS(bound->nReads++);
+        _lowerNodeValue(bound, &bound->readValue);
+    }
+
+    MPI_Rget_accumulate(NULL, 0, MPI_DOUBLE, &bound->readValue, BOUND_COUNT, MPI_DOUBLE, BOUND_OWNER, 0, BOUND_COUNT,
+                        MPI_DOUBLE, MPI_NO_OP, bound->win, &bound->readRequest);
+}
+
+// returns whether the value was lowered
+bool tspBoundPoll(tspBound_t* bound, tspBoundValue_t* value) {
+    if (bound->isNodeLeader)
+        _pollWindow(bound);
+
+    tspBoundValue_t nodeValue;
+    __atomic_load(&bound->nodeValue->cost, &nodeValue.cost, __ATOMIC_ACQUIRE);
+    __atomic_load(&bound->nodeValue->priority, &nodeValue.priority, __ATOMIC_ACQUIRE);
+    return _minValue(value, &nodeValue);
+}
@@ -0,0 +1,23 @@
+#ifndef __TSP__TSP_BOUND_H__
+#define __TSP__TSP_BOUND_H__
+
+#include "include.h"
+#include "tspApi.h"
+#include <mpi.h>
+
+#define BOUND_OWNER 0
+
+typedef struct {
+    double cost;
+    double priority;
+} tspBoundValue_t;
+
+typedef struct _tspBound tspBound_t;
+
+tspBound_t* tspBoundCreate(const tspApi_t* api, const tspBoundValue_t* value);
+void tspBoundDestroy(tspBound_t* bound);
+
+void tspBoundOffer(tspBound_t* bound, tspBoundValue_t* value);
+bool tspBoundPoll(tspBound_t* bound, tspBoundValue_t* value);
+
+#endif // __TSP__TSP_BOUND_H__
@@ -0,0 +1,155 @@
+#include "tspComm.h"
+
+typedef struct {
+    int tag;
+    MPI_Datatype datatype;
+    int maxCount;
+    int typeSize;
+    void* buffer;
+    bool isPending;
+} tspCommChannel_t;
+
+struct _tspComm {
+    int procId;
+    tspProfile_t* profile;
+    int nChannels;
+    tspCommChannel_t channels[COMM_MAX_CHANNELS];
+    MPI_Request requests[COMM_MAX_CHANNELS];
+    int nReady;
+    int nextReady;
+    int ready[COMM_MAX_CHANNELS];
+    MPI_Status statuses[COMM_MAX_CHANNELS];
+    unsigned long nTests;
+    unsigned long nWaits;
+    unsigned long nMessages;
+    double waitTime;
+    double startTime;
+};
+
+tspComm_t* tspCommCreate(int procId, tspProfile_t* profile) {
+    tspComm_t* comm = (tspComm_t*)malloc(sizeof(tspComm_t));
+    comm->procId = procId;
+    comm->profile = profile;
+    comm->nChannels = 0;
+    comm->nReady = 0;
+    comm->nextReady = 0;
+    comm->nTests = 0;
+    comm->nWaits = 0;
+    comm->nMessages = 0;
+    comm->waitTime = 0;
+    comm->startTime = MPI_Wtime();
+    return comm;
+}
+
+#ifdef __STATS__
+static void _logStats(tspComm_t* comm) {
+    unsigned long local[3] = {comm->nTests, comm->nWaits, comm->nMessages};
+    unsigned long total[3] = {0, 0, 0};
+    double waitTime = 0, elapsedTime = MPI_Wtime() - comm->startTime, maxElapsedTime = 0;
+    MPI_Reduce(local, total, 3, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&comm->waitTime, &waitTime, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&elapsedTime, &maxElapsedTime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (comm->procId == 0) {
+        STATS_LOG("received messages = %lu (%.0f per second)", total[2], total[2] / maxElapsedTime);
+        STATS_LOG("message polls = %lu", total[0]);
+        STATS_LOG("blocking waits = %lu (%.3fs)", total[1], waitTime);
+    }
+}
+#endif
+
+// the receives still posted when the search ends have no matching message, so they are cancelled
+void tspCommDestroy(tspComm_t* comm) {
+    STATS(_logStats(comm));
+    for (int i = 0; i < comm->nChannels; i++) {
+        if (comm->channels[i].isPending) {
+            MPI_Cancel(&comm->requests[i]);
+            MPI_Wait(&comm->requests[i], MPI_STATUS_IGNORE);
+        }
+        MPI_Request_free(&comm->requests[i]);
+        free(comm->channels[i].buffer);
+    }
+    free(comm);
+}
+
+static inline int _typeSize(MPI_Datatype datatype) {
+    int typeSize;
+    MPI_Type_size(datatype, &typeSize);
+    return typeSize;
+}
+
+void tspCommSend(tspComm_t* comm, const void* buffer, int count, MPI_Datatype datatype, int procId, int tag) {
+    PROFILE(tspProfileEnter(comm->profile, PROFILE_SEND));
+    MPI_Send(buffer, count, datatype, procId, tag, MPI_COMM_WORLD);
+    PROFILE(tspProfileLeave(comm->profile, PROFILE_SEND));
+    PROFILE(tspProfileMessage(comm->profile, tag, count * _typeSize(datatype), true));
+#ifndef __PROFILE__
+    (void)comm;
+#endif
+}
+
+void tspCommListen(tspComm_t* comm, int tag, MPI_Datatype datatype, int maxCount) {
+    int index = comm->nChannels++;
+    tspCommChannel_t* channel = &comm->channels[index];
+    MPI_Aint lowerBound, extent;
+    MPI_Type_get_extent(datatype, &lowerBound, &extent);
+
+    channel->tag = tag;
+    channel->datatype = datatype;
+    channel->maxCount = maxCount;
+    channel->typeSize = _typeSize(datatype);
+    channel->buffer = malloc(maxCount * extent);
+    channel->isPending = true;
+    MPI_Recv_init(channel->buffer, maxCount, datatype, MPI_ANY_SOURCE, tag, MPI_COMM_WORLD, &comm->requests[index]);
+    MPI_Start(&comm->requests[index]);
+}
+
+static void _readMessage(tspComm_t* comm, int index, MPI_Status* status, tspCommMessage_t* message) {
+    tspCommChannel_t* channel = &comm->channels[index];
+    channel->isPending = false;
+    message->channel = index;
+    message->tag = channel->tag;
+    message->source = status->MPI_SOURCE;
+    message->buffer = channel->buffer;
+    MPI_Get_count(status, channel->datatype, &message->count);
+    STATS(comm->nMessages++);
+    PROFILE(tspProfileMessage(comm->profile, channel->tag, message->count * channel->typeSize, false));
+}
+
+// the receives completed by one test are handed out one at a time before the requests are tested again
+bool tspCommTest(tspComm_t* comm, tspCommMessage_t* message) {
+    if (comm->nextReady == comm->nReady) {
+        STATS(comm->nTests++);
+        comm->nextReady = 0;
+        PROFILE(tspProfileEnter(comm->profile, PROFILE_POLL));
+        MPI_Testsome(comm->nChannels, comm->requests, &comm->nReady, comm->ready, comm->statuses);
+        PROFILE(tspProfileLeave(comm->profile, PROFILE_POLL));
+        if (comm->nReady == MPI_UNDEFINED)
+            comm->nReady = 0;
+        if (comm->nReady == 0)
+            return false;
+    }
+
+    int next = comm->nextReady++;
+    _readMessage(comm, comm->ready[next], &comm->statuses[next], message);
+    return true;
+}
+
+void tspCommWait(tspComm_t* comm, tspCommMessage_t* message) {
+    if (tspCommTest(comm, message))
+        return;
+
+    int index;
+    MPI_Status status;
+    STATS(comm->nWaits++);
+    STATS(double waitStart = MPI_Wtime());
+    PROFILE(tspProfileEnter(comm->profile, PROFILE_IDLE));
+    MPI_Waitany(comm->nChannels, comm->requests, &index, &status);
+    PROFILE(tspProfileLeave(comm->profile, PROFILE_IDLE));
+    STATS(comm->waitTime += MPI_Wtime() - waitStart);
+    _readMessage(comm, index, &status, message);
+}
+
+void tspCommRelease(tspComm_t* comm, const tspCommMessage_t* message) {
+    comm->channels[message->channel].isPending = true;
+    MPI_Start(&comm->requests[message->channel]);
+}
@@ -0,0 +1,29 @@
+#ifndef __TSP__TSP_COMM_H__
+#define __TSP__TSP_COMM_H__
+
+#include "include.h"
+#include "tspProfile.h"
+#include <mpi.h>
+
+#define COMM_MAX_CHANNELS 8
+
+typedef struct {
+    int channel;
+    int tag;
+    int source;
+    int count;
+    void* buffer;
+} tspCommMessage_t;
+
+typedef struct _tspComm tspComm_t;
+
+tspComm_t* tspCommCreate(int procId, tspProfile_t* profile);
+void tspCommDestroy(tspComm_t* comm);
+
+void tspCommSend(tspComm_t* comm, const void* buffer, int count, MPI_Datatype datatype, int procId, int tag);
+void tspCommListen(tspComm_t* comm, int tag, MPI_Datatype datatype, int maxCount);
+bool tspCommTest(tspComm_t* comm, tspCommMessage_t* message);
+void tspCommWait(tspComm_t* comm, tspCommMessage_t* message);
+void tspCommRelease(tspComm_t* comm, const tspCommMessage_t* message);
+
+#endif // __TSP__TSP_COMM_H__
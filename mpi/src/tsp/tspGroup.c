@@ -0,0 +1,41 @@
+#include "tspGroup.h"
+
+static int _nodeColor(const tspApi_t* api) {
+    int leaderId = api->procId;
+    MPI_Bcast(&leaderId, 1, MPI_INT, 0, api->nodeComm);
+    return leaderId * api->nProcs + api->nodeRank / GROUP_MAX_SIZE;
+}
+
+tspGroup_t* tspGroupCreate(const tspApi_t* api) {
+    tspGroup_t* group = (tspGroup_t*)malloc(sizeof(tspGroup_t));
+    MPI_Comm groupComm;
+    MPI_Comm_split(MPI_COMM_WORLD, _nodeColor(api), api->procId, &groupComm);
+    MPI_Comm_size(groupComm, &group->nMembers);
+    MPI_Comm_rank(groupComm, &group->memberIndex);
+    group->members = (int*)malloc(group->nMembers * sizeof(int));
+    MPI_Allgather(&api->procId, 1, MPI_INT, group->members, 1, MPI_INT, groupComm);
+    MPI_Comm_free(&groupComm);
+
+    int isCoordinator = (group->memberIndex == 0);
+    int* isCoordinators = (int*)malloc(api->nProcs * sizeof(int));
+    MPI_Allgather(&isCoordinator, 1, MPI_INT, isCoordinators, 1, MPI_INT, MPI_COMM_WORLD);
+    group->isCoordinator = isCoordinator;
+    group->nCoordinators = 0;
+    group->coordinatorIndex = -1;
+    group->coordinators = (int*)malloc(api->nProcs * sizeof(int));
+    for (int procId = 0; procId < api->nProcs; procId++) {
+        if (!isCoordinators[procId])
+            continue;
+        if (procId == api->procId)
+            group->coordinatorIndex = group->nCoordinators;
+        group->coordinators[group->nCoordinators++] = procId;
+    }
+    free(isCoordinators);
+    return group;
+}
+
+void tspGroupDestroy(tspGroup_t* group) {
+    free(group->members);
+    free(group->coordinators);
+    free(group);
+}
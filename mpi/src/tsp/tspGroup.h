@@ -0,0 +1,24 @@
+#ifndef __TSP__TSP_GROUP_H__
+#define __TSP__TSP_GROUP_H__
+
+#include "include.h"
+#include "tspApi.h"
+#include <mpi.h>
+
+#define GROUP_MAX_SIZE 8
+
+// the ranks of a node are split in groups of at most GROUP_MAX_SIZE, whose first rank coordinates the group
+typedef struct {
+    int nMembers;
+    int memberIndex;
+    int* members;
+    int nCoordinators;
+    int coordinatorIndex;
+    int* coordinators;
+    bool isCoordinator;
+} tspGroup_t;
+
+tspGroup_t* tspGroupCreate(const tspApi_t* api);
+void tspGroupDestroy(tspGroup_t* group);
+
+#endif // __TSP__TSP_GROUP_H__
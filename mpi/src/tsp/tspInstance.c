@@ -0,0 +1,47 @@
+#include "tspInstance.h"
+
+struct _tspInstance {
+    MPI_Win win;
+};
+
+// only rank 0 reads the instance, which reaches the first rank of every node with a single broadcast and is then
+// moved to a window every rank of the node maps, so each host keeps a single copy of the road costs
+tspInstance_t* tspInstanceShare(const tspApi_t* api, tsp_t* tsp) {
+    tspInstance_t* instance = (tspInstance_t*)malloc(sizeof(tspInstance_t));
+    int size[2] = {tsp->nCities, tsp->nRoads};
+    MPI_Bcast(size, 2, MPI_INT, 0, MPI_COMM_WORLD);
+    int nCities = size[0];
+
+    double* costs;
+    MPI_Aint nCosts = nCities * nCities + nCities * TSP_TOTAL_MIN_COSTS;
+    MPI_Win_allocate_shared((api->nodeRank == 0 ? nCosts * sizeof(double) : 0), sizeof(double), MPI_INFO_NULL,
+                            api->nodeComm, &costs, &instance->win);
+    if (api->nodeRank == 0) {
+        if (api->procId == 0) {
+            for (int i = 0; i < nCities; i++)
+                memcpy(costs + i * nCities, tsp->roadCosts[i], nCities * sizeof(double));
+            memcpy(costs + nCities * nCities, tsp->minCosts, nCities * TSP_TOTAL_MIN_COSTS * sizeof(double));
+            tspDestroy(tsp);
+        }
+        MPI_Bcast(costs, nCosts, MPI_DOUBLE, 0, api->leaderComm);
+    } else {
+        MPI_Aint windowSize;
+        int dispUnit;
+        MPI_Win_shared_query(instance->win, 0, &windowSize, &dispUnit, &costs);
+    }
+    MPI_Barrier(api->nodeComm);
+
+    tsp->nCities = nCities;
+    tsp->nRoads = size[1];
+    tsp->roadCosts = (double**)malloc(nCities * sizeof(double*));
+    for (int i = 0; i < nCities; i++)
+        tsp->roadCosts[i] = costs + i * nCities;
+    tsp->minCosts = costs + nCities * nCities;
+    return instance;
+}
+
+void tspInstanceDestroy(tspInstance_t* instance, tsp_t* tsp) {
+    free(tsp->roadCosts);
+    MPI_Win_free(&instance->win);
+    free(instance);
+}
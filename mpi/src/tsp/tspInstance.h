@@ -0,0 +1,14 @@
+#ifndef __TSP__TSP_INSTANCE_H__
+#define __TSP__TSP_INSTANCE_H__
+
+#include "include.h"
+#include "tsp.h"
+#include "tspApi.h"
+#include <mpi.h>
+
+typedef struct _tspInstance tspInstance_t;
+
+tspInstance_t* tspInstanceShare(const tspApi_t* api, tsp_t* tsp);
+void tspInstanceDestroy(tspInstance_t* instance, tsp_t* tsp);
+
+#endif // __TSP__TSP_INSTANCE_H__
@@ -6,6 +6,7 @@ tspNode_t* tspNodeCreate(double cost, double lb, int length, int currentCity) {
     node->lb = lb;
     node->priority = lb * MAX_CITIES + currentCity;
     node->length = length;
+    node->sibling = 0;
     node->tour[node->length - 1] = currentCity;
     node->visited = 0x00000001 << currentCity;
     return node;
@@ -28,6 +29,7 @@ tspNode_t* tspNodeInit(tspNode_t* node, double cost, double lb, int length, int
     node->lb = lb;
     node->priority = lb * MAX_CITIES + currentCity;
     node->length = length;
+    node->sibling = 0;
     node->tour[node->length - 1] = currentCity;
     node->visited = 0x00000001 << currentCity;
     return node;
@@ -40,6 +42,57 @@ tspNode_t* tspNodeInitExt(tspNode_t* node, const tspNode_t* parent, double cost,
     return node;
 }
 
+// only the part of the tour that differs from the previous node in the buffer is packed
+char* tspNodePack(const tspNode_t* node, const tspNode_t* prevNode, char* buffer) {
+    int prefix = 1;
+    while (prevNode != NULL && prefix < node->length && prefix < prevNode->length &&
+           node->tour[prefix] == prevNode->tour[prefix])
+        prefix++;
+
+    *buffer++ = (char)node->length;
+    *buffer++ = (char)node->sibling;
+    *buffer++ = (char)prefix;
+    memcpy(buffer, &node->cost, sizeof(double));
+    buffer += sizeof(double);
+    memcpy(buffer, &node->lb, sizeof(double));
+    buffer += sizeof(double);
+    // the priority of a lazy cursor is the one of its next child, otherwise it follows from the lower bound
+    if (node->sibling != 0) {
+        memcpy(buffer, &node->priority, sizeof(double));
+        buffer += sizeof(double);
+    }
+    memcpy(buffer, node->tour + prefix, node->length - prefix);
+    return buffer + node->length - prefix;
+}
+
+const char* tspNodeUnpack(tspNode_t* node, const tspNode_t* prevNode, const char* buffer) {
+    int length = *buffer++;
+    int sibling = *buffer++;
+    int prefix = *buffer++;
+    double cost, lb, priority;
+    memcpy(&cost, buffer, sizeof(double));
+    buffer += sizeof(double);
+    memcpy(&lb, buffer, sizeof(double));
+    buffer += sizeof(double);
+    if (sibling != 0) {
+        memcpy(&priority, buffer, sizeof(double));
+        buffer += sizeof(double);
+    }
+
+    node->tour[0] = 0;
+    if (prevNode != NULL)
+        memcpy(node->tour, prevNode->tour, prefix);
+    memcpy(node->tour + prefix, buffer, length - prefix);
+    tspNodeInit(node, cost, lb, length, node->tour[length - 1]);
+    for (int i = 0; i < length - 1; i++)
+        node->visited |= 1ULL << node->tour[i];
+    if (sibling != 0) {
+        node->sibling = sibling;
+        node->priority = priority;
+    }
+    return buffer + length - prefix;
+}
+
 void tspNodeCopyTour(const tspNode_t* node, char* tour) {
     for (int i = 0; i < node->length; i++)
         tour[i] = node->tour[i];
@@ -9,10 +9,14 @@ typedef struct {
     double lb;
     double priority;
     int length;
+    int sibling;
     char tour[MAX_CITIES];
     unsigned long long visited;
 } tspNode_t;
 
+// a packed node has a 3 byte header, its cost, lower bound and (for lazy cursors) priority, and part of its tour
+#define NODE_MAX_PACKED_SIZE (3 + 3 * sizeof(double) + MAX_CITIES)
+
 tspNode_t* tspNodeCreate(double cost, double lb, int length, int currentCity);
 tspNode_t* tspNodeCreateExt(const tspNode_t* parent, double cost, double lb, int currentCity);
 void tspNodeDestroy(tspNode_t* node);
@@ -20,6 +24,9 @@ void tspNodeDestroy(tspNode_t* node);
 tspNode_t* tspNodeInit(tspNode_t* node, double cost, double lb, int length, int currentCity);
 tspNode_t* tspNodeInitExt(tspNode_t* node, const tspNode_t* parent, double cost, double lb, int currentCity);
 
+char* tspNodePack(const tspNode_t* node, const tspNode_t* prevNode, char* buffer);
+const char* tspNodeUnpack(tspNode_t* node, const tspNode_t* prevNode, const char* buffer);
+
 void tspNodeCopyTour(const tspNode_t* node, char* container);
 void tspNodePrint(const tspNode_t* node);
 
@@ -0,0 +1,209 @@
+#include "tspProfile.h"
+
+#ifdef __PROFILE__
+#define PROFILE_TOTAL_COUNTERS 4
+#define PROFILE_TOTAL_TIMES (PROFILE_TOTAL_PHASES + 3)
+
+typedef struct {
+    double start;
+    double end;
+    int phase;
+} tspProfileEvent_t;
+
+// the messages of each tag are counted as sent, sent bytes, received and received bytes
+struct _tspProfile {
+    int procId;
+    int nProcs;
+    double startTime;
+    double enterTime[PROFILE_TOTAL_PHASES];
+    double phaseTime[PROFILE_TOTAL_PHASES];
+    unsigned long messages[PROFILE_TOTAL_TAGS][PROFILE_TOTAL_COUNTERS];
+    const char* tracePath;
+    tspProfileEvent_t* events;
+    int nEvents;
+    unsigned long nDropped;
+};
+
+static const char* _phaseNames[PROFILE_TOTAL_PHASES] = {"compute", "send", "poll", "idle"};
+
+static const char* _tagName(int tag) {
+    switch (tag) {
+    case MPI_TAG_NODE:
+        return "NODE";
+    case MPI_TAG_TOKEN:
+        return "TOKEN";
+    case MPI_TAG_TERMINATED:
+        return "TERMINATED";
+    case MPI_TAG_INIT:
+        return "INIT";
+    case MPI_TAG_ASK_NODE:
+        return "ASK_NODE";
+    default:
+        return NULL;
+    }
+}
+
+// rank 0 decides whether the ranks trace, since the other hosts may not get its environment, and the ranks start their
+// clocks together, so the timelines of a host line up in the trace
+tspProfile_t* tspProfileCreate(const tspApi_t* api) {
+    tspProfile_t* profile = (tspProfile_t*)calloc(1, sizeof(tspProfile_t));
+    profile->procId = api->procId;
+    profile->nProcs = api->nProcs;
+    profile->tracePath = getenv(PROFILE_TRACE_ENV);
+    int isTracing = (profile->tracePath != NULL);
+    MPI_Bcast(&isTracing, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (isTracing)
+        profile->events = (tspProfileEvent_t*)malloc(PROFILE_MAX_EVENTS * sizeof(tspProfileEvent_t));
+    MPI_Barrier(MPI_COMM_WORLD);
+    profile->startTime = MPI_Wtime();
+    return profile;
+}
+
+void tspProfileDestroy(tspProfile_t* profile) {
+    free(profile->events);
+    free(profile);
+}
+
+void tspProfileEnter(tspProfile_t* profile, tspProfilePhase_t phase) { profile->enterTime[phase] = MPI_Wtime(); }
+
+// the polls are too short and too frequent to be traced, and a span that follows another of the same phase after a
+// short gap extends it, so the trace stays small
+static void _traceEvent(tspProfile_t* profile, tspProfilePhase_t phase, double start, double end) {
+    if (profile->events == NULL || phase == PROFILE_POLL)
+        return;
+
+    tspProfileEvent_t* last = (profile->nEvents > 0 ? &profile->events[profile->nEvents - 1] : NULL);
+    if (last != NULL && last->phase == (int)phase && start - last->end < PROFILE_MERGE_GAP) {
+        last->end = end;
+    } else if (profile->nEvents < PROFILE_MAX_EVENTS) {
+        tspProfileEvent_t event = {start - profile->startTime, end - profile->startTime, phase};
+        profile->events[profile->nEvents++] = event;
+    } else {
+        profile->nDropped++;
+    }
+}
+
+void tspProfileLeave(tspProfile_t* profile, tspProfilePhase_t phase) {
+    double start = profile->enterTime[phase], end = MPI_Wtime();
+    profile->phaseTime[phase] += end - start;
+    _traceEvent(profile, phase, start, end);
+}
+
+void tspProfileMessage(tspProfile_t* profile, int tag, int nBytes, bool isSent) {
+    unsigned long* counters = profile->messages[tag - PROFILE_FIRST_TAG];
+    counters[isSent ? 0 : 2]++;
+    counters[isSent ? 1 : 3] += nBytes;
+}
+
+static void _reportTimes(tspProfile_t* profile) {
+    double local[PROFILE_TOTAL_TIMES], *times = NULL;
+    double elapsedTime = MPI_Wtime() - profile->startTime, otherTime = elapsedTime;
+    for (int i = 0; i < PROFILE_TOTAL_PHASES; i++) {
+        local[i] = profile->phaseTime[i];
+        otherTime -= profile->phaseTime[i];
+    }
+    local[PROFILE_TOTAL_PHASES] = otherTime;
+    local[PROFILE_TOTAL_PHASES + 1] = 0;
+    local[PROFILE_TOTAL_PHASES + 2] = 0;
+    for (int i = 0; i < PROFILE_TOTAL_TAGS; i++) {
+        local[PROFILE_TOTAL_PHASES + 1] += profile->messages[i][0];
+        local[PROFILE_TOTAL_PHASES + 2] += profile->messages[i][2];
+    }
+
+    if (profile->procId == 0)
+        times = (double*)malloc(profile->nProcs * PROFILE_TOTAL_TIMES * sizeof(double));
+    MPI_Gather(local, PROFILE_TOTAL_TIMES, MPI_DOUBLE, times, PROFILE_TOTAL_TIMES, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (profile->procId != 0)
+        return;
+
+    PROFILE_LOG("%5s %9s %9s %9s %9s %9s %9s %9s", "rank", "compute", "send", "poll", "idle", "other", "sent",
+                "received");
+    for (int procId = 0; procId < profile->nProcs; procId++) {
+        const double* row = &times[procId * PROFILE_TOTAL_TIMES];
+        PROFILE_LOG("%5d %8.3fs %8.3fs %8.3fs %8.3fs %8.3fs %9.0f %9.0f", procId, row[0], row[1], row[2], row[3],
+                    row[4], row[5], row[6]);
+    }
+    free(times);
+}
+
+static void _reportMessages(tspProfile_t* profile) {
+    unsigned long total[PROFILE_TOTAL_TAGS][PROFILE_TOTAL_COUNTERS];
+    MPI_Reduce(profile->messages, total, PROFILE_TOTAL_TAGS * PROFILE_TOTAL_COUNTERS, MPI_UNSIGNED_LONG, MPI_SUM, 0,
+               MPI_COMM_WORLD);
+    if (profile->procId != 0)
+        return;
+
+    PROFILE_LOG("%-10s %9s %12s %9s %12s", "tag", "sent", "sent bytes", "received", "recv bytes");
+    for (int i = 0; i < PROFILE_TOTAL_TAGS; i++) {
+        const char* name = _tagName(PROFILE_FIRST_TAG + i);
+        if (name != NULL)
+            PROFILE_LOG("%-10s %9lu %12lu %9lu %12lu", name, total[i][0], total[i][1], total[i][2], total[i][3]);
+    }
+}
+
+// every rank is a thread of a single process in the trace, which any chrome trace viewer can open
+static void _writeTrace(const tspProfile_t* profile, const tspProfileEvent_t* events, const int* nEvents) {
+    FILE* file = fopen(profile->tracePath, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Unable to open the file: %s\n", profile->tracePath);
+        return;
+    }
+
+    fprintf(file, "{\"traceEvents\": [\n");
+    for (int procId = 0; procId < profile->nProcs; procId++) {
+        fprintf(file, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, ", procId);
+        fprintf(file, "\"args\": {\"name\": \"rank %d\"}},\n", procId);
+    }
+    for (int procId = 0, i = 0; procId < profile->nProcs; procId++) {
+        for (int end = i + nEvents[procId]; i < end; i++) {
+            fprintf(file, "{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, ", _phaseNames[events[i].phase],
+                    procId);
+            fprintf(file, "\"ts\": %.3f, \"dur\": %.3f},\n", 1e6 * events[i].start,
+                    1e6 * (events[i].end - events[i].start));
+        }
+    }
+    fprintf(file, "{\"name\": \"end\", \"ph\": \"i\", \"pid\": 0, \"tid\": 0, \"ts\": 0}\n]}\n");
+    fclose(file);
+}
+
+static void _gatherTrace(tspProfile_t* profile) {
+    int* nEvents = NULL;
+    int* displacements = NULL;
+    tspProfileEvent_t* events = NULL;
+    int nBytes = profile->nEvents * sizeof(tspProfileEvent_t), nTotalBytes = 0;
+    unsigned long nDropped = 0;
+    if (profile->procId == 0) {
+        nEvents = (int*)malloc(profile->nProcs * sizeof(int));
+        displacements = (int*)malloc(profile->nProcs * sizeof(int));
+    }
+    MPI_Reduce(&profile->nDropped, &nDropped, 1, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Gather(&nBytes, 1, MPI_INT, nEvents, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (profile->procId == 0) {
+        for (int procId = 0; procId < profile->nProcs; procId++) {
+            displacements[procId] = nTotalBytes;
+            nTotalBytes += nEvents[procId];
+        }
+        events = (tspProfileEvent_t*)malloc(nTotalBytes);
+    }
+    MPI_Gatherv(profile->events, nBytes, MPI_BYTE, events, nEvents, displacements, MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    if (profile->procId == 0) {
+        for (int procId = 0; procId < profile->nProcs; procId++)
+            nEvents[procId] /= sizeof(tspProfileEvent_t);
+        _writeTrace(profile, events, nEvents);
+        PROFILE_LOG("trace = %s (%d events, %lu dropped)", profile->tracePath,
+                    nTotalBytes / (int)sizeof(tspProfileEvent_t), nDropped);
+    }
+    free(events);
+    free(displacements);
+    free(nEvents);
+}
+
+// every rank takes part in the report, which rank 0 prints
+void tspProfileReport(tspProfile_t* profile) {
+    _reportTimes(profile);
+    _reportMessages(profile);
+    if (profile->events != NULL)
+        _gatherTrace(profile);
+}
+#endif
@@ -0,0 +1,34 @@
+#ifndef __TSP__TSP_PROFILE_H__
+#define __TSP__TSP_PROFILE_H__
+
+#include "include.h"
+#include "tspApi.h"
+#include <mpi.h>
+
+#define PROFILE_MAX_EVENTS 65536
+#define PROFILE_MERGE_GAP 1e-4
+#define PROFILE_TRACE_ENV "TSP_TRACE"
+
+// the messages are counted by tag, from the first to the last tag of tspApi.h
+#define PROFILE_FIRST_TAG MPI_TAG_NODE
+#define PROFILE_TOTAL_TAGS (MPI_TAG_ASK_NODE - MPI_TAG_NODE + 1)
+
+typedef enum {
+    PROFILE_COMPUTE,
+    PROFILE_SEND,
+    PROFILE_POLL,
+    PROFILE_IDLE,
+    PROFILE_TOTAL_PHASES,
+} tspProfilePhase_t;
+
+typedef struct _tspProfile tspProfile_t;
+
+tspProfile_t* tspProfileCreate(const tspApi_t* api);
+void tspProfileDestroy(tspProfile_t* profile);
+
+void tspProfileEnter(tspProfile_t* profile, tspProfilePhase_t phase);
+void tspProfileLeave(tspProfile_t* profile, tspProfilePhase_t phase);
+void tspProfileMessage(tspProfile_t* profile, int tag, int nBytes, bool isSent);
+void tspProfileReport(tspProfile_t* profile);
+
+#endif // __TSP__TSP_PROFILE_H__
@@ -1,16 +1,67 @@
 #include "tspSolver.h"
 #include "tspApi.h"
+#include "tspBalance.h"
+#include "tspBound.h"
+#include "tspComm.h"
+#include "tspGroup.h"
 #include "tspNode.h"
+#include "tspProfile.h"
 #include "utils/queue.h"
 #include <math.h>
 #include <mpi.h>
 #include <time.h>
 
+#define PURGE_MIN_NODES 1024
+#define PURGE_MIN_IMPROVEMENT 0.01
+#define RAMP_UP_NODES 16
+#define STEAL_BATCH 32
+#define POLL_INTERVAL 64
+
+// the ramp-up stops as soon as there are enough nodes, so the last expansion adds at most one node per city
+#define INIT_MAX_NODES (RAMP_UP_NODES + MAX_CITIES)
+
+// the termination token adds up the work messages sent minus the ones received by the ranks it visited
+typedef struct {
+    int count;
+    int isBlack;
+} tspToken_t;
+
 typedef struct {
     const tsp_t* tsp;
     tspApi_t* api;
+    tspComm_t* comm;
+    tspProfile_t* profile;
+    tspGroup_t* group;
+    tspBound_t* sharedBound;
+    tspBalance_t* balance;
     tspSolution_t* solution;
+    tspBoundValue_t bound;
+    char* packBuffer;
     priorityQueue_t* queue;
+    double purgePriority;
+    unsigned long nPurged;
+    bool isInit;
+    bool isStealing;
+    bool isDone;
+    int nStolen;
+    int nFailedSteals;
+    unsigned int seed;
+    int workCount;
+    bool isBlack;
+    bool hasToken;
+    tspToken_t token;
+    int nFrontier;
+    double startTime;
+    double rampUpTime;
+    double busyTime;
+    unsigned long nExpanded;
+    unsigned long nCreated;
+    unsigned long nRequests;
+    unsigned long nRemoteRequests;
+    unsigned long nRecvNodes;
+    unsigned long nSentNodes;
+    unsigned long nSentBytes;
+    unsigned long nTokenRounds;
 } tspSolverData_t;
 
 tspSolution_t* tspSolutionCreate(double maxTourCost) {
@@ -23,18 +74,6 @@ tspSolution_t* tspSolutionCreate(double maxTourCost) {
 
 void tspSolutionDestroy(tspSolution_t* solution) { free(solution); }
 
-static inline bool _isBetterSolution(tspSolution_t* oldSolution, tspSolution_t* newSolution) {
-    return newSolution->priority < oldSolution->priority;
-}
-
-static void _copySolution(const tsp_t* tsp, tspSolution_t* srcSolution, tspSolution_t* destSolution) {
-    destSolution->hasSolution = srcSolution->hasSolution;
-    destSolution->cost = srcSolution->cost;
-    destSolution->priority = srcSolution->priority;
-    for (int i = 0; i < tsp->nCities; i++)
-        destSolution->tour[i] = srcSolution->tour[i];
-}
-
 static int __tspNodeCmpFun(void* el1, void* el2) {
     tspNode_t* node1 = (tspNode_t*)el1;
     tspNode_t* node2 = (tspNode_t*)el2;
@@ -46,6 +85,11 @@ static void __tspNodeDestroyFun(void* el) {
     tspNodeDestroy(node);
 }
 
+static bool __tspNodeIsPromisingFun(void* el, void* arg) {
+    tspNode_t* node = (tspNode_t*)el;
+    return node->priority <= *(double*)arg;
+}
+
 static inline bool _isCityInTour(const tspNode_t* node, int cityNumber) {
     return node->visited & (0x00000001 << cityNumber);
 }
@@ -59,6 +103,22 @@ static tspNode_t* _getNextNode(priorityQueue_t* queue, double solutionPriority)
     return node;
 }
 
+static inline bool _isCanonicalOrientation(const tsp_t* tsp, const tspNode_t* parent, int nextCity) {
+#ifdef __SYMMETRY_BREAKING__
+    // keeps the orientation whose last city is lower than the first, i.e. the one with the lower priority
+    if (parent->length + 1 >= tsp->nCities)
+        return true;
+    int firstCity = (parent->length == 1 ? nextCity : parent->tour[1]);
+    unsigned long long visited = parent->visited | (1ULL << nextCity);
+    return (~visited & ((1ULL << firstCity) - 1)) != 0;
+#else
+    (void)tsp;
+    (void)parent;
+    (void)nextCity;
+    return true;
+#endif
+}
+
 static double _calculateInitialLb(const tsp_t* tsp) {
     double sum = 0.0;
     for (int i = 0; i < tsp->nCities; i++)
@@ -78,6 +138,27 @@ static double _calculateLb(const tsp_t* tsp, const tspNode_t* node, int nextCity
     return node->lb + costFromTo - (costFrom + costTo) / 2;
 }
 
+// pruned nodes are otherwise only dropped once popped, so the frontier is compacted after large enough improvements
+static void _purgeFrontier(tspSolverData_t* solverData) {
+    double solutionPriority = solverData->bound.priority;
+    if (queueSize(solverData->queue) < PURGE_MIN_NODES ||
+        solutionPriority > solverData->purgePriority * (1 - PURGE_MIN_IMPROVEMENT))
+        return;
+
+    solverData->nPurged +=
+        queueFilter(solverData->queue, __tspNodeIsPromisingFun, &solutionPriority, __tspNodeDestroyFun);
+    solverData->purgePriority = solutionPriority;
+}
+
+static void _lowerBound(tspSolverData_t* solverData, const tspBoundValue_t* bound) {
+    if (bound->cost < solverData->bound.cost)
+        solverData->bound.cost = bound->cost;
+    if (bound->priority < solverData->bound.priority) {
+        solverData->bound.priority = bound->priority;
+        _purgeFrontier(solverData);
+    }
+}
+
 static void _updateBestTour(tspSolverData_t* solverData, const tspNode_t* finalNode) {
     const tsp_t* tsp = solverData->tsp;
     tspSolution_t* solution = solverData->solution;
@@ -85,206 +166,525 @@ static void _updateBestTour(tspSolverData_t* solverData, const tspNode_t* finalN
     int currentCity = tspNodeCurrentCity(finalNode);
     double cost = finalNode->cost + tsp->roadCosts[currentCity][0];
     double priority = cost * MAX_CITIES + currentCity;
-    if (priority < solution->priority) {
+    if (priority < solverData->bound.priority) {
         tspNodeCopyTour(finalNode, solution->tour);
         solution->hasSolution = true;
         solution->cost = cost;
         solution->priority = cost * MAX_CITIES + solution->tour[tsp->nCities - 1];
 
-        for (int i = 0; i < solverData->api->nProcs; i++) {
-            if (i == solverData->api->procId)
-                continue;
-            MPI_Send(solution, 1, solverData->api->solution_t, i, MPI_TAG_SOLUTION, MPI_COMM_WORLD);
+        // only the bound is shared, the tours stay with the rank that found them until the search ends
+        tspBoundValue_t bound = {cost, priority};
+        if (solverData->sharedBound != NULL)
+            tspBoundOffer(solverData->sharedBound, &bound);
+        _lowerBound(solverData, &bound);
+    }
+}
+
+#ifdef __LAZY_EXPANSION__
+typedef struct {
+    int city;
+    double lb;
+    double priority;
+} tspChild_t;
+
+static int _sortedChildren(const tsp_t* tsp, const tspNode_t* parent, tspChild_t* children) {
+    int parentCurrentCity = tspNodeCurrentCity(parent);
+    int nChildren = 0;
+    for (int cityNumber = 0; cityNumber < tsp->nCities; cityNumber++) {
+        if (tspIsNeighbour(tsp, parentCurrentCity, cityNumber) && !_isCityInTour(parent, cityNumber) &&
+            _isCanonicalOrientation(tsp, parent, cityNumber)) {
+            double lb = _calculateLb(tsp, parent, cityNumber);
+            tspChild_t child = {cityNumber, lb, lb * MAX_CITIES + cityNumber};
+            int i = nChildren++;
+            for (; i > 0 && children[i - 1].priority > child.priority; i--)
+                children[i] = children[i - 1];
+            children[i] = child;
         }
     }
+    return nChildren;
+}
+
+static int _nextSibling(const tspSolverData_t* solverData, const tspChild_t* children, int nChildren, int sibling) {
+    while (sibling < nChildren && children[sibling].lb > solverData->bound.cost)
+        sibling++;
+    return sibling;
 }
 
-static void _visitNeighbors(tspSolverData_t* solverData, const tspNode_t* parent) {
+// only the best pending child is created, the parent is pushed back as a cursor to its next sibling
+static bool _visitNeighbors(tspSolverData_t* solverData, tspNode_t* parent) {
+    const tsp_t* tsp = solverData->tsp;
+    int parentCurrentCity = tspNodeCurrentCity(parent);
+    tspChild_t children[MAX_CITIES];
+    int nChildren = _sortedChildren(tsp, parent, children);
+
+    int sibling = _nextSibling(solverData, children, nChildren, parent->sibling);
+    if (sibling == nChildren)
+        return false;
+
+    const tspChild_t* child = &children[sibling];
+    double cost = parent->cost + tsp->roadCosts[parentCurrentCity][child->city];
+    tspNode_t* nextNode = tspNodeCreateExt(parent, cost, child->lb, child->city);
+    STATS(solverData->nCreated++);
+    queuePush(solverData->queue, nextNode);
+
+    sibling = _nextSibling(solverData, children, nChildren, sibling + 1);
+    if (sibling == nChildren)
+        return false;
+
+    parent->sibling = sibling;
+    parent->priority = children[sibling].priority;
+    queuePush(solverData->queue, parent);
+    return true;
+}
+#else
+static bool _visitNeighbors(tspSolverData_t* solverData, tspNode_t* parent) {
     const tsp_t* tsp = solverData->tsp;
     int parentCurrentCity = tspNodeCurrentCity(parent);
     for (int cityNumber = 0; cityNumber < tsp->nCities; cityNumber++) {
-        if (tspIsNeighbour(tsp, parentCurrentCity, cityNumber) && !_isCityInTour(parent, cityNumber)) {
+        if (tspIsNeighbour(tsp, parentCurrentCity, cityNumber) && !_isCityInTour(parent, cityNumber) &&
+            _isCanonicalOrientation(tsp, parent, cityNumber)) {
             double lb = _calculateLb(tsp, parent, cityNumber);
-            if (lb > solverData->solution->cost)
+            if (lb > solverData->bound.cost)
                 continue;
             double cost = parent->cost + tsp->roadCosts[parentCurrentCity][cityNumber];
             tspNode_t* nextNode = tspNodeCreateExt(parent, cost, lb, cityNumber);
+            STATS(solverData->nCreated++);
             queuePush(solverData->queue, nextNode);
         }
     }
+    return false;
 }
+#endif
 
-static void _processNode(tspSolverData_t* solverData, tspNode_t* node) {
+static bool _processNode(tspSolverData_t* solverData, tspNode_t* node) {
     const tsp_t* tsp = solverData->tsp;
-    if ((node->length == tsp->nCities) && tspIsNeighbour(tsp, tspNodeCurrentCity(node), 0))
+    STATS(solverData->nExpanded++);
+    if ((node->length == tsp->nCities) && tspIsNeighbour(tsp, tspNodeCurrentCity(node), 0)) {
         _updateBestTour(solverData, node);
-    else
-        _visitNeighbors(solverData, node);
+        return false;
+    }
+    return _visitNeighbors(solverData, node);
+}
+
+// the nodes are packed one after the other into the send buffer, which every transfer reuses
+static void _sendNodes(tspSolverData_t* solverData, tspNode_t** nodes, int nNodes, int procId, int tag) {
+    char* end = solverData->packBuffer;
+    for (int i = 0; i < nNodes; i++)
+        end = tspNodePack(nodes[i], (i > 0 ? nodes[i - 1] : NULL), end);
+
+    int nBytes = end - solverData->packBuffer;
+    tspCommSend(solverData->comm, solverData->packBuffer, nBytes, MPI_BYTE, procId, tag);
+    if (nNodes > 0)
+        solverData->workCount++;
+    STATS(solverData->nSentNodes += nNodes);
+    STATS(solverData->nSentBytes += nBytes);
+}
+
+static int _recvNodes(tspSolverData_t* solverData, const char* buffer, int nBytes) {
+    const char* end = buffer + nBytes;
+    tspNode_t* prevNode = NULL;
+    int nNodes = 0;
+    for (; buffer < end; nNodes++) {
+        tspNode_t* node = (tspNode_t*)malloc(sizeof(tspNode_t));
+        buffer = tspNodeUnpack(node, prevNode, buffer);
+        queuePush(solverData->queue, node);
+        prevNode = node;
+    }
+    if (nNodes > 0) {
+        solverData->workCount--;
+        solverData->isBlack = true;
+    }
+    return nNodes;
+}
+
+static inline void _markBusy(tspSolverData_t* solverData) {
+    if (solverData->busyTime == INFINITY)
+        solverData->busyTime = MPI_Wtime() - solverData->startTime;
+}
+
+static int __tspNodeBreadthFirstCmpFun(void* el1, void* el2) {
+    tspNode_t* node1 = (tspNode_t*)el1;
+    tspNode_t* node2 = (tspNode_t*)el2;
+    if (node1->length != node2->length)
+        return (node2->length < node1->length ? 1 : 0);
+    return (node2->priority < node1->priority ? 1 : 0);
 }
 
-void _recvSolution(tspSolverData_t* solverData, MPI_Status* status) {
-    tspSolution_t recvSolution;
-    MPI_Status statusSolution;
-    MPI_Recv(&recvSolution, 1, solverData->api->solution_t, status->MPI_SOURCE, status->MPI_TAG, MPI_COMM_WORLD,
-             &statusSolution);
+// the sorted frontier is dealt in a snake order (0, 1, .., n-1, n-1, .., 0, 0, ..), which balances the bounds
+static inline int _frontierOwner(int index, int nProcs) {
+    int round = index % (2 * nProcs);
+    return (round < nProcs ? round : 2 * nProcs - 1 - round);
+}
 
-    if (_isBetterSolution(solverData->solution, &recvSolution))
-        _copySolution(solverData->tsp, &recvSolution, solverData->solution);
+static void _dealFrontier(tspSolverData_t* solverData, priorityQueue_t* frontier) {
+    tspApi_t* api = solverData->api;
+    int nNodes = 0;
+    tspNode_t** nodes = (tspNode_t**)malloc(queueSize(frontier) * sizeof(tspNode_t*));
+    while (queueSize(frontier) > 0) {
+        tspNode_t* node = _getNextNode(frontier, solverData->bound.priority);
+        if (node != NULL)
+            nodes[nNodes++] = node;
+    }
+    solverData->nFrontier = nNodes;
+
+    // every rank gets its whole share in the message that lets it start stealing
+    tspNode_t** share = (tspNode_t**)malloc((nNodes / api->nProcs + 1) * sizeof(tspNode_t*));
+    for (int procId = 1; procId < api->nProcs; procId++) {
+        int nShare = 0;
+        for (int i = 0; i < nNodes; i++)
+            if (_frontierOwner(i, api->nProcs) == procId)
+                share[nShare++] = nodes[i];
+        _sendNodes(solverData, share, nShare, procId, MPI_TAG_INIT);
+    }
+    for (int i = 0; i < nNodes; i++) {
+        if (_frontierOwner(i, api->nProcs) == 0)
+            queuePush(solverData->queue, nodes[i]);
+        else
+            tspNodeDestroy(nodes[i]);
+    }
+    free(share);
+    free(nodes);
 }
-void _recvNode(tspSolverData_t* solverData, MPI_Status* status) {
-    tspNode_t* node;
-    MPI_Status statusNode;
-    node = tspNodeCreate(0, 0, 1, 0);
-    MPI_Recv(node, 1, solverData->api->node_t, status->MPI_SOURCE, status->MPI_TAG, MPI_COMM_WORLD, &statusNode);
-    queuePush(solverData->queue, node);
+
+// rank 0 expands the shallowest nodes first until every rank can get a few subproblems of similar depth
+static void _rampUp(tspSolverData_t* solverData) {
+    priorityQueue_t* queue = solverData->queue;
+    solverData->queue = queueCreate(__tspNodeBreadthFirstCmpFun);
+
+    tspNode_t* startNode = tspNodeCreate(0, _calculateInitialLb(solverData->tsp), 1, 0);
+    if (!_processNode(solverData, startNode))
+        tspNodeDestroy(startNode);
+    while (queueSize(solverData->queue) > 0 &&
+           queueSize(solverData->queue) < (size_t)(RAMP_UP_NODES * solverData->api->nProcs)) {
+        tspNode_t* node = _getNextNode(solverData->queue, solverData->bound.priority);
+        if (node != NULL && !_processNode(solverData, node))
+            tspNodeDestroy(node);
+    }
+
+    priorityQueue_t* frontier = queueCreate(__tspNodeCmpFun);
+    while (queueSize(solverData->queue) > 0)
+        queuePush(frontier, queuePop(solverData->queue));
+    queueDestroy(solverData->queue, NULL);
+    solverData->queue = queue;
+
+    _dealFrontier(solverData, frontier);
+    queueDestroy(frontier, NULL);
+    solverData->rampUpTime = MPI_Wtime() - solverData->startTime;
 }
 
 void _singleProcSolve(tspSolverData_t* solverData) {
     tspNode_t* startNode = tspNodeCreate(0, _calculateInitialLb(solverData->tsp), 1, 0);
-    _processNode(solverData, startNode);
-    tspNodeDestroy(startNode);
+    if (!_processNode(solverData, startNode))
+        tspNodeDestroy(startNode);
 
     while (true) {
-        tspNode_t* node = _getNextNode(solverData->queue, solverData->solution->priority);
+        tspNode_t* node = _getNextNode(solverData->queue, solverData->bound.priority);
         if (node == NULL)
             break;
-        _processNode(solverData, node);
-        tspNodeDestroy(node);
+        _markBusy(solverData);
+        if (!_processNode(solverData, node))
+            tspNodeDestroy(node);
     }
 }
 
-void _multipleProcSolve(tspSolverData_t* solverData) {
-    if (solverData->api->procType == PROCTYPE_MASTER) {
-        // Initialization
-        int flag;
-        int next = 1;
-        bool isInit = true;
-        bool temp = false;
-        bool isTerminated[solverData->api->nProcs];
-        memset(isTerminated, false, solverData->api->nProcs * sizeof(bool));
-
-        tspNode_t* startNode = tspNodeCreate(0, _calculateInitialLb(solverData->tsp), 1, 0);
-        _processNode(solverData, startNode);
-        tspNodeDestroy(startNode);
-
-        int numCycles = (solverData->api->nProcs + 2 - 1) / 2;
-        for (int i = 0; i < numCycles; i++) {
-            tspNode_t* node = _getNextNode(solverData->queue, solverData->solution->priority);
-            if (node == NULL)
-                break;
-            _processNode(solverData, node);
+// a batch of nodes is expanded between two polls, so the cost of testing the receives is spread over the batch
+static int _processBatch(tspSolverData_t* solverData) {
+    PROFILE(tspProfileEnter(solverData->profile, PROFILE_COMPUTE));
+    int nProcessed = 0;
+    for (; nProcessed < POLL_INTERVAL; nProcessed++) {
+        tspNode_t* node = _getNextNode(solverData->queue, solverData->bound.priority);
+        if (node == NULL)
+            break;
+        _markBusy(solverData);
+        if (!_processNode(solverData, node))
             tspNodeDestroy(node);
-        }
+    }
+    PROFILE(tspProfileLeave(solverData->profile, PROFILE_COMPUTE));
+    return nProcessed;
+}
 
-        for (int i = 0; i < (2 * solverData->api->nProcs); i++) {
-            tspNode_t* node = _getNextNode(solverData->queue, solverData->solution->priority);
-            if (node == NULL)
-                break;
-            MPI_Send(node, 1, solverData->api->node_t, next, MPI_TAG_NODE, MPI_COMM_WORLD);
-            next = (next + 1) % solverData->api->nProcs;
-            if (next == 0)
-                next = 1; //(id + 1) % nprocs;
-            tspNodeDestroy(node);
+// the thief gets every other node from the top of the queue, so both ranks keep some of the best nodes
+static void _serveSteal(tspSolverData_t* solverData, int thief) {
+    tspNode_t* nodes[STEAL_BATCH];
+    tspNode_t* keptNodes[STEAL_BATCH];
+    int nNodes = 0, nKeptNodes = 0;
+    while (nNodes < STEAL_BATCH) {
+        tspNode_t* node = _getNextNode(solverData->queue, solverData->bound.priority);
+        if (node == NULL)
+            break;
+        nodes[nNodes++] = node;
+
+        node = _getNextNode(solverData->queue, solverData->bound.priority);
+        if (node == NULL)
+            break;
+        keptNodes[nKeptNodes++] = node;
+    }
+    for (int i = 0; i < nKeptNodes; i++)
+        queuePush(solverData->queue, keptNodes[i]);
+    _sendNodes(solverData, nodes, nNodes, thief, MPI_TAG_NODE);
+    for (int i = 0; i < nNodes; i++)
+        tspNodeDestroy(nodes[i]);
+}
+
+static void _handleMessage(tspSolverData_t* solverData, tspCommMessage_t* message) {
+    if (message->tag == MPI_TAG_ASK_NODE) {
+        _serveSteal(solverData, message->source);
+    } else if (message->tag == MPI_TAG_NODE) {
+        solverData->nStolen = _recvNodes(solverData, (char*)message->buffer, message->count);
+        STATS(solverData->nRecvNodes += solverData->nStolen);
+        solverData->isStealing = false;
+    } else if (message->tag == MPI_TAG_INIT) {
+        _recvNodes(solverData, (char*)message->buffer, message->count);
+        solverData->isInit = true;
+    } else if (message->tag == MPI_TAG_TOKEN) {
+        solverData->token = *(tspToken_t*)message->buffer;
+        solverData->hasToken = true;
+    } else if (message->tag == MPI_TAG_TERMINATED) {
+        solverData->isDone = true;
+    }
+    tspCommRelease(solverData->comm, message);
+}
+
+static void _pollMessages(tspSolverData_t* solverData) {
+    tspCommMessage_t message;
+    while (tspCommTest(solverData->comm, &message))
+        _handleMessage(solverData, &message);
+}
+
+static void _waitMessages(tspSolverData_t* solverData) {
+    tspCommMessage_t message;
+    tspCommWait(solverData->comm, &message);
+    _handleMessage(solverData, &message);
+    _pollMessages(solverData);
+}
+
+static void _terminate(tspSolverData_t* solverData) {
+    bool temp = false;
+    for (int i = 1; i < solverData->api->nProcs; i++)
+        tspCommSend(solverData->comm, &temp, 1, MPI_C_BOOL, i, MPI_TAG_TERMINATED);
+    solverData->isDone = true;
+}
+
+// Safra's algorithm: passive ranks pass the token around the ring, and it returns to rank 0 white with a zero count
+// only if every rank stayed passive and no work message is in flight
+static void _passToken(tspSolverData_t* solverData) {
+    tspApi_t* api = solverData->api;
+    tspToken_t* token = &solverData->token;
+    if (!solverData->hasToken)
+        return;
+
+    if (api->procId == 0) {
+        if (!token->isBlack && !solverData->isBlack && token->count + solverData->workCount == 0) {
+            _terminate(solverData);
+            return;
         }
+        token->count = 0;
+        token->isBlack = false;
+        STATS(solverData->nTokenRounds++);
+    } else {
+        token->count += solverData->workCount;
+        token->isBlack |= solverData->isBlack;
+    }
+    solverData->isBlack = false;
+    solverData->hasToken = false;
+    tspCommSend(solverData->comm, token, 2, MPI_INT, (api->procId + 1) % api->nProcs, MPI_TAG_TOKEN);
+}
 
-        for (int i = 1; i < solverData->api->nProcs; i++)
-            MPI_Send(&isInit, 1, MPI_C_BOOL, i, MPI_TAG_INIT, MPI_COMM_WORLD);
-
-        // Works as special Process
-        next = 1;
-
-        while (true) {
-            flag = false;
-            MPI_Status status;
-            MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &flag, &status);
-
-            if (flag) {
-                if (status.MPI_TAG == MPI_TAG_SOLUTION)
-                    _recvSolution(solverData, &status);
-                else if (status.MPI_TAG == MPI_TAG_NODE)
-                    _recvNode(solverData, &status);
-                else if (status.MPI_TAG == MPI_TAG_ASK_NODE) {
-                    MPI_Recv(&temp, 1, MPI_C_BOOL, status.MPI_SOURCE, status.MPI_TAG, MPI_COMM_WORLD, NULL);
-                    tspNode_t* node = _getNextNode(solverData->queue, solverData->solution->priority);
-                    if (node == NULL) {
-                        MPI_Send(&temp, 1, MPI_C_BOOL, status.MPI_SOURCE, MPI_TAG_TODO1, MPI_COMM_WORLD);
-                        isTerminated[status.MPI_SOURCE] = true;
-                        bool terminated = true;
-                        for (int i = 1; i < solverData->api->nProcs; i++)
-                            if (!isTerminated[i])
-                                terminated = false;
-                        if (terminated)
-                            break;
-                    } else {
-                        MPI_Send(node, 1, solverData->api->node_t, status.MPI_SOURCE, MPI_TAG_TODO2, MPI_COMM_WORLD);
-                    }
-                }
-            }
-            tspNode_t* node = _getNextNode(solverData->queue, solverData->solution->priority);
-
-            if (node == NULL)
-                continue;
+// members only steal inside their group, coordinators also steal from the other coordinators after a failed attempt
+static int _chooseVictim(tspSolverData_t* solverData) {
+    tspGroup_t* group = solverData->group;
+    bool isRemote = group->isCoordinator && group->nCoordinators > 1 &&
+                    (group->nMembers == 1 || solverData->nFailedSteals % 2 == 1);
+    const int* procIds = (isRemote ? group->coordinators : group->members);
+    int nProcs = (isRemote ? group->nCoordinators : group->nMembers);
+    int index = (isRemote ? group->coordinatorIndex : group->memberIndex);
+    STATS(solverData->nRemoteRequests += isRemote);
+    return procIds[(index + 1 + rand_r(&solverData->seed) % (nProcs - 1)) % nProcs];
+}
 
-            _processNode(solverData, node);
-            tspNodeDestroy(node);
+static void _askNodes(tspSolverData_t* solverData, int victim) {
+    bool temp = false;
+    tspCommSend(solverData->comm, &temp, 1, MPI_C_BOOL, victim, MPI_TAG_ASK_NODE);
+    STATS(solverData->nRequests++);
+    solverData->isStealing = true;
+}
+
+// a passive rank keeps asking random victims for nodes, serving other thieves and passing the token while it waits
+static void _stealNodes(tspSolverData_t* solverData) {
+    if (!solverData->isStealing)
+        _askNodes(solverData, _chooseVictim(solverData));
+    while (solverData->isStealing && !solverData->isDone) {
+        _waitMessages(solverData);
+        if (solverData->isStealing)
+            _passToken(solverData);
+    }
+    solverData->nFailedSteals = (solverData->nStolen > 0 ? 0 : solverData->nFailedSteals + 1);
+}
+
+// a rank whose best node lags far behind the best node of all ranks asks the rank that holds it for nodes, without
+// waiting for them, so the ranks keep expanding nodes close to the global best first order
+static void _rebalance(tspSolverData_t* solverData) {
+    double priority = INFINITY;
+    if (queueSize(solverData->queue) > 0) {
+        tspNode_t* node = queuePeek(solverData->queue);
+        if (node->priority <= solverData->bound.priority)
+            priority = node->priority;
+    }
+    int victim = tspBalancePoll(solverData->balance, priority);
+    if (victim >= 0 && !solverData->isStealing)
+        _askNodes(solverData, victim);
+}
+
+static void _search(tspSolverData_t* solverData) {
+    while (!solverData->isDone) {
+        if (_processBatch(solverData) > 0) {
+            tspBoundValue_t bound = solverData->bound;
+            if (tspBoundPoll(solverData->sharedBound, &bound))
+                _lowerBound(solverData, &bound);
+            _pollMessages(solverData);
+            _rebalance(solverData);
+            continue;
         }
 
+        _passToken(solverData);
+        if (solverData->isDone)
+            break;
+        if (solverData->isInit)
+            _stealNodes(solverData);
+        else
+            _waitMessages(solverData);
+    }
+}
+
+// the steal requests still in flight are answered before the ranks leave, so no message is left unmatched
+static void _drainMessages(tspSolverData_t* solverData) {
+    while (solverData->isStealing)
+        _waitMessages(solverData);
+
+    MPI_Request request;
+    int isDrained = false;
+    MPI_Ibarrier(MPI_COMM_WORLD, &request);
+    while (!isDrained) {
+        _pollMessages(solverData);
+        MPI_Test(&request, &isDrained, MPI_STATUS_IGNORE);
+    }
+}
+
+// the best tour is only gathered once, from the rank that found it
+static void _reduceSolution(tspSolverData_t* solverData) {
+    struct {
+        double priority;
+        int procId;
+    } local = {solverData->solution->priority, solverData->api->procId}, best;
+    MPI_Allreduce(&local, &best, 1, MPI_DOUBLE_INT, MPI_MINLOC, MPI_COMM_WORLD);
+    MPI_Bcast(solverData->solution, 1, solverData->api->solution_t, best.procId, MPI_COMM_WORLD);
+}
+
+// every rank searches its share of the ramp-up frontier and steals from the other ranks once it runs out of nodes
+void _multipleProcSolve(tspSolverData_t* solverData) {
+    tspApi_t* api = solverData->api;
+    PROFILE(solverData->profile = tspProfileCreate(api));
+    tspComm_t* comm = tspCommCreate(api->procId, solverData->profile);
+    solverData->comm = comm;
+    solverData->group = tspGroupCreate(api);
+    solverData->sharedBound = tspBoundCreate(api, &solverData->bound);
+    solverData->balance = tspBalanceCreate(api);
+    solverData->packBuffer = (char*)malloc(INIT_MAX_NODES * NODE_MAX_PACKED_SIZE);
+    tspCommListen(comm, MPI_TAG_ASK_NODE, MPI_C_BOOL, 1);
+    tspCommListen(comm, MPI_TAG_NODE, MPI_BYTE, STEAL_BATCH * NODE_MAX_PACKED_SIZE);
+    tspCommListen(comm, MPI_TAG_TOKEN, MPI_INT, 2);
+    if (api->procType == PROCTYPE_MASTER) {
+        _rampUp(solverData);
+        solverData->isInit = true;
+        solverData->hasToken = true;
     } else {
-        // All Other processes
-
-        int flag;
-        bool isInit = false; // can only ask nodes after initialization has finished
-        int MASTER_SOURCE = 0;
-        bool askedMaster = false; // used only for ask once to master for a node
-        bool temp = false;
-
-        while (true) {
-            flag = false;
-            MPI_Status status;
-            MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &flag, &status);
-
-            if (flag) {
-                if (status.MPI_TAG == MPI_TAG_SOLUTION)
-                    _recvSolution(solverData, &status);
-                else if (status.MPI_TAG == MPI_TAG_NODE)
-                    _recvNode(solverData, &status);
-                else if (status.MPI_TAG == MPI_TAG_TODO2) {
-                    _recvNode(solverData, &status);
-                    askedMaster = false;
-                } else if (status.MPI_TAG == MPI_TAG_TODO1) {
-                    MPI_Status tempStatus;
-                    MPI_Recv(&temp, 1, MPI_C_BOOL, MASTER_SOURCE, status.MPI_TAG, MPI_COMM_WORLD, &tempStatus);
-                    break;
-                } else if (status.MPI_TAG == MPI_TAG_INIT) {
-                    MPI_Status tempStatus;
-                    MPI_Recv(&isInit, 1, MPI_C_BOOL, 0, status.MPI_TAG, MPI_COMM_WORLD, &tempStatus);
-                }
-            }
-            tspNode_t* node = _getNextNode(solverData->queue, solverData->solution->priority);
-
-            if (node == NULL) {
-                if (!askedMaster && isInit) {
-                    // ask master for a new node
-                    MPI_Send(&temp, 1, MPI_C_BOOL, MASTER_SOURCE, MPI_TAG_ASK_NODE, MPI_COMM_WORLD);
-                    askedMaster = true;
-                }
-                continue;
-            } else {
-                _processNode(solverData, node);
-                tspNodeDestroy(node);
-            }
-        }
+        tspCommListen(comm, MPI_TAG_INIT, MPI_BYTE, INIT_MAX_NODES * NODE_MAX_PACKED_SIZE);
+        tspCommListen(comm, MPI_TAG_TERMINATED, MPI_C_BOOL, 1);
+    }
+
+    _search(solverData);
+    _drainMessages(solverData);
+    PROFILE(tspProfileReport(solverData->profile));
+    PROFILE(tspProfileDestroy(solverData->profile));
+    tspCommDestroy(comm);
+    tspGroupDestroy(solverData->group);
+    tspBoundDestroy(solverData->sharedBound);
+    tspBalanceDestroy(solverData->balance);
+    free(solverData->packBuffer);
+    _reduceSolution(solverData);
+}
+
+#ifdef __STATS__
+static void _logStats(tspSolverData_t* solverData) {
+    unsigned long nExpanded = 0, nCreated = 0, nPurged = 0, nRequests = 0, nRemoteRequests = 0, nRecvNodes = 0;
+    unsigned long nSentNodes = 0, nSentBytes = 0;
+    double busyTime = 0;
+    int isBusy = (solverData->busyTime != INFINITY), nBusyProcs = 0;
+    MPI_Reduce(&solverData->busyTime, &busyTime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&isBusy, &nBusyProcs, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&solverData->nExpanded, &nExpanded, 1, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&solverData->nCreated, &nCreated, 1, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&solverData->nPurged, &nPurged, 1, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&solverData->nRequests, &nRequests, 1, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&solverData->nRemoteRequests, &nRemoteRequests, 1, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&solverData->nRecvNodes, &nRecvNodes, 1, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&solverData->nSentNodes, &nSentNodes, 1, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&solverData->nSentBytes, &nSentBytes, 1, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (solverData->api->procId == 0) {
+        STATS_LOG("expanded nodes = %lu", nExpanded);
+        STATS_LOG("created nodes = %lu", nCreated);
+        STATS_LOG("purged nodes = %lu (%.1f MB)", nPurged,
+                  nPurged * (sizeof(tspNode_t) + sizeof(void*)) / (1024.0 * 1024.0));
+        STATS_LOG("ramp-up = %.3fms (%d subproblems)", 1e3 * solverData->rampUpTime, solverData->nFrontier);
+        if (nBusyProcs == solverData->api->nProcs)
+            STATS_LOG("full utilization after %.3fms", 1e3 * busyTime);
+        else
+            STATS_LOG("full utilization never reached (%d busy ranks)", nBusyProcs);
+        STATS_LOG("steal requests = %lu (%lu between groups)", nRequests, nRemoteRequests);
+        STATS_LOG("termination token rounds = %lu", solverData->nTokenRounds);
+        STATS_LOG("stolen nodes = %lu", nRecvNodes);
+        if (nSentNodes > 0)
+            STATS_LOG("sent nodes = %lu (%.1f bytes per node)", nSentNodes, (double)nSentBytes / nSentNodes);
     }
 }
+#endif
 
-tspSolution_t* tspSolve(const tsp_t* tsp, double maxTourCost) {
+tspSolution_t* tspSolve(const tsp_t* tsp, double maxTourCost, tspApi_t* api) {
     tspSolverData_t solverData;
     solverData.tsp = tsp;
-    solverData.api = tspApiCreate();
+    solverData.api = api;
     solverData.solution = tspSolutionCreate(maxTourCost);
     solverData.queue = queueCreate(__tspNodeCmpFun);
-
-    tspApiInit(solverData.api);
+    solverData.profile = NULL;
+    solverData.sharedBound = NULL;
+    solverData.bound.cost = solverData.solution->cost;
+    solverData.bound.priority = solverData.solution->priority;
+    solverData.purgePriority = solverData.solution->priority;
+    solverData.nPurged = 0;
+    solverData.isInit = false;
+    solverData.isStealing = false;
+    solverData.isDone = false;
+    solverData.nStolen = 0;
+    solverData.nFailedSteals = 0;
+    solverData.workCount = 0;
+    solverData.isBlack = false;
+    solverData.hasToken = false;
+    solverData.token.count = 0;
+    solverData.token.isBlack = true;
+    solverData.nFrontier = 0;
+    solverData.rampUpTime = 0;
+    solverData.busyTime = INFINITY;
+    solverData.nExpanded = 0;
+    solverData.nCreated = 0;
+    solverData.nRequests = 0;
+    solverData.nRemoteRequests = 0;
+    solverData.nRecvNodes = 0;
+    solverData.nSentNodes = 0;
+    solverData.nSentBytes = 0;
+    solverData.nTokenRounds = 0;
+
+    solverData.seed = (unsigned int)solverData.api->procId;
+    solverData.startTime = MPI_Wtime();
 
     if (solverData.api->nProcs == 1) {
         _singleProcSolve(&solverData);
@@ -292,14 +692,7 @@ tspSolution_t* tspSolve(const tsp_t* tsp, double maxTourCost) {
         _multipleProcSolve(&solverData);
     }
 
-    int procId = solverData.api->procId;
-    tspApiTerminate(solverData.api);
-    tspApiDestroy(solverData.api);
+    STATS(_logStats(&solverData));
     queueDestroy(solverData.queue, __tspNodeDestroyFun);
-    if (procId) {
-        tspSolutionDestroy(solverData.solution);
-        exit(EXIT_SUCCESS);
-    } else {
-        return solverData.solution;
-    }
+    return solverData.solution;
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "include.h"
 #include "tsp.h"
+#include "tspApi.h"
 
 typedef struct {
     bool hasSolution;
@@ -13,6 +14,6 @@ typedef struct {
 
 tspSolution_t* tspSolutionCreate(double maxTourCost);
 void tspSolutionDestroy(tspSolution_t* tspSolution);
-tspSolution_t* tspSolve(const tsp_t* tsp, double maxTourCost);
+tspSolution_t* tspSolve(const tsp_t* tsp, double maxTourCost, tspApi_t* api);
 
 #endif // __TSP__TSP_SOLVER_H__
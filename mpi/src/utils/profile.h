@@ -0,0 +1,12 @@
+#ifndef __UTILS__PROFILE_H__
+#define __UTILS__PROFILE_H__
+
+#ifdef __PROFILE__
+#define PROFILE(X) X
+#define PROFILE_LOG(X, ...) fprintf(stderr, "[Profile]: " X "\n", __VA_ARGS__)
+#else
+#define PROFILE(X)
+#define PROFILE_LOG(X, ...)
+#endif
+
+#endif // __UTILS__PROFILE_H__
@@ -0,0 +1,54 @@
+#!/bin/bash
+
+if [ $# -lt 1 ] ; then
+	echo "Usage: ${0} <test_name> [max threads] [none|compact|scatter]"
+	exit 1
+fi
+
+PATH_DIR=$(dirname $(realpath $0))
+PATH_TEST=${PATH_DIR}/../test
+PATH_OUT_1=${PATH_TEST}/out/base
+PATH_OUT_2=${PATH_TEST}/out/inverted
+PATH_RES=${PATH_DIR}/bin/res.txt
+PATH_TIME=${PATH_DIR}/bin/time.txt
+
+IN=${1}
+MAX_THREADS=${2:-$(nproc)}
+POLICY=${3:-compact}
+OUT_1=${PATH_OUT_1}/$(basename ${IN} .in).out
+OUT_2=${PATH_OUT_2}/$(basename ${IN} .in).out
+TEST=$(basename $IN)
+RUN=${PATH_DIR}/tsp-omp
+MAX_VALUE=$(echo ${TEST} | sed -n "s/^.*-\([0-9]*\).*$/\1/p")
+
+printf "\e[33m%s (affinity = %s)\e[0m\n" ${TEST} ${POLICY}
+printf "%8s %10s %10s %10s\n" "threads" "time" "speedup" "efficiency"
+
+BASE_TIME=""
+THREADS=1
+while [ ${THREADS} -le ${MAX_THREADS} ]; do
+	START=$(date +%s.%N)
+	${RUN} -t ${THREADS} -a ${POLICY} ${IN} ${MAX_VALUE} 1> ${PATH_RES} 2> ${PATH_TIME}
+	END=$(date +%s.%N)
+	TIME=$(awk "BEGIN { print ${END} - ${START} }")
+	BASE_TIME=${BASE_TIME:-${TIME}}
+
+	if diff ${PATH_RES} ${OUT_1} >/dev/null || diff ${PATH_RES} ${OUT_2} >/dev/null; then
+		STATUS="\e[32m[Succ]\e[0m"
+	else
+		STATUS="\e[31m[Fail]\e[0m"
+	fi
+
+	SPEEDUP=$(awk "BEGIN { print ${BASE_TIME} / ${TIME} }")
+	EFFICIENCY=$(awk "BEGIN { print ${SPEEDUP} / ${THREADS} }")
+	printf "%8d %9.2fs %10.2f %10.2f ${STATUS}\n" ${THREADS} ${TIME} ${SPEEDUP} ${EFFICIENCY}
+
+	if [ ${THREADS} -lt ${MAX_THREADS} ] && [ $((THREADS * 2)) -gt ${MAX_THREADS} ]; then
+		THREADS=${MAX_THREADS}
+	else
+		THREADS=$((THREADS * 2))
+	fi
+done
+
+rm -f ${PATH_RES}
+rm -f ${PATH_TIME}
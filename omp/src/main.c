@@ -1,33 +1,65 @@
 #include "include.h"
 #include "tsp/tspSolver.h"
+#include <getopt.h>
 #include <omp.h>
 
+#define BATCH_WINDOW_PER_THREAD 4
+#define BATCH_MAX_PATH 4096
+#define BATCH_MAX_LINE (BATCH_MAX_PATH + 64)
+#define BATCH_SMALL_INSTANCE 20
+
+typedef struct {
+    int lineId;
+    char path[BATCH_MAX_PATH];
+    double maxTourCost;
+    tsp_t tsp;
+    tspSolution_t* solution;
+    bool isParsed;
+    bool isDone;
+} batchInstance_t;
+
 FILE* openFile(const char* path, const char* mode) {
     FILE* file = fopen(path, mode);
     if (file == NULL) {
-        printf("Unable to open the file: %s\n", path);
+        fprintf(stderr, "Unable to open the file: %s\n", path);
         exit(1);
     }
     return file;
 }
 
-tsp_t parseInput(const char* inPath) {
-    FILE* inputFile = openFile(inPath, "r");
+// an instance that cannot be read is reported on the standard error and left to the caller, so a batch goes on
+bool parseInput(const char* inPath, tsp_t* tsp) {
+    FILE* inputFile = fopen(inPath, "r");
+    if (inputFile == NULL) {
+        fprintf(stderr, "Unable to open the file: %s\n", inPath);
+        return false;
+    }
+
     size_t nCities, nRoads;
-    fscanf(inputFile, "%lu %lu\n", &nCities, &nRoads);
-    tsp_t tsp = tspCreate(nCities, nRoads);
+    if (fscanf(inputFile, "%lu %lu\n", &nCities, &nRoads) != 2 || nCities == 0) {
+        fprintf(stderr, "Invalid header in the file: %s\n", inPath);
+        fclose(inputFile);
+        return false;
+    }
+    *tsp = tspCreate(nCities, nRoads);
 
-    for (int i = 0; i < tsp.nRoads; i++) {
+    for (int i = 0; i < tsp->nRoads; i++) {
         int cityA, cityB;
         double cost;
-        fscanf(inputFile, "%d %d %le\n", &cityA, &cityB, &cost);
-        tsp.roadCosts[cityA][cityB] = cost;
-        tsp.roadCosts[cityB][cityA] = cost;
+        if (fscanf(inputFile, "%d %d %le\n", &cityA, &cityB, &cost) != 3 || cityA < 0 || cityA >= tsp->nCities ||
+            cityB < 0 || cityB >= tsp->nCities) {
+            fprintf(stderr, "Invalid road %d in the file: %s\n", i + 1, inPath);
+            fclose(inputFile);
+            tspDestroy(tsp);
+            return false;
+        }
+        tsp->roadCosts[cityA][cityB] = cost;
+        tsp->roadCosts[cityB][cityA] = cost;
     }
 
     fclose(inputFile);
-    tspInitializeMinCosts(&tsp);
-    return tsp;
+    tspInitializeMinCosts(tsp);
+    return true;
 }
 
 void printSolution(const tsp_t* tsp, const tspSolution_t* solution) {
@@ -41,21 +73,162 @@ void printSolution(const tsp_t* tsp, const tspSolution_t* solution) {
     }
 }
 
+void printUsage() {
+    printf("Usage: ./tsp [-t <num_threads>] [-a none|compact|scatter] <cities_file> <max_value>\n");
+    printf("       ./tsp [-t <num_threads>] [-a none|compact|scatter] --batch [<manifest_file>]\n");
+    exit(1);
+}
+
+// the manifest is read a window at a time, so the instances are streamed, and a line that is not a
+// <cities_file> <max_value> pair is reported and skipped
+static int _readWindow(FILE* manifestFile, batchInstance_t* window, int windowSize, int* lineId) {
+    char line[BATCH_MAX_LINE], format[32], maxValue[32];
+    snprintf(format, sizeof(format), "%%%ds %%31s", BATCH_MAX_PATH - 1);
+    int nInstances = 0;
+    while (nInstances < windowSize && fgets(line, sizeof(line), manifestFile) != NULL) {
+        (*lineId)++;
+        batchInstance_t* instance = &window[nInstances];
+        int nFields = sscanf(line, format, instance->path, maxValue);
+        if (nFields <= 0)
+            continue;
+        if (nFields != 2) {
+            fprintf(stderr, "instance %d failed: invalid manifest line\n", *lineId);
+            continue;
+        }
+
+        instance->lineId = *lineId;
+        instance->maxTourCost = atoi(maxValue);
+        instance->solution = NULL;
+        instance->isParsed = false;
+        instance->isDone = false;
+        nInstances++;
+    }
+    return nInstances;
+}
+
+// the results are printed in the order of the manifest, as soon as every earlier instance is done, and each instance is
+// freed once printed
+static void _printReady(batchInstance_t* window, int nInstances, int* nPrinted, int* nFailed) {
+    for (; *nPrinted < nInstances && window[*nPrinted].isDone; (*nPrinted)++) {
+        batchInstance_t* instance = &window[*nPrinted];
+        if (instance->solution != NULL) {
+            printSolution(&instance->tsp, instance->solution);
+            tspSolutionDestroy(instance->solution);
+        } else {
+            fprintf(stderr, "instance %d failed: %s\n", instance->lineId, instance->path);
+            (*nFailed)++;
+        }
+        if (instance->isParsed)
+            tspDestroy(&instance->tsp);
+    }
+    fflush(stdout);
+}
+
+void solveBatch(FILE* manifestFile, int nThreads, const threadPlacement_t* placement) {
+    int windowSize = BATCH_WINDOW_PER_THREAD * nThreads;
+    batchInstance_t* window = (batchInstance_t*)malloc(windowSize * sizeof(batchInstance_t));
+    int lineId = 0, nSolved = 0, nFailed = 0, nInstances;
+
+    double execTime = -omp_get_wtime();
+    while ((nInstances = _readWindow(manifestFile, window, windowSize, &lineId)) > 0) {
+        int nPrinted = 0;
+
+        // small instances are solved independently, one per thread
+#pragma omp parallel num_threads(nThreads)
+        {
+            threadPlacementPin(placement, omp_get_thread_num());
+
+#pragma omp for schedule(dynamic, 1)
+            for (int i = 0; i < nInstances; i++) {
+                batchInstance_t* instance = &window[i];
+                instance->isParsed = parseInput(instance->path, &instance->tsp);
+                bool isSmall = (instance->isParsed && instance->tsp.nCities <= BATCH_SMALL_INSTANCE);
+                if (isSmall)
+                    instance->solution = tspSolve(&instance->tsp, instance->maxTourCost, 1, NULL);
+
+#pragma omp critical(batchPrint)
+                {
+                    instance->isDone = (!instance->isParsed || isSmall);
+                    _printReady(window, nInstances, &nPrinted, &nFailed);
+                }
+            }
+        }
+
+        // large instances are solved one at a time by the whole team
+        for (int i = nPrinted; i < nInstances; i++) {
+            batchInstance_t* instance = &window[i];
+            if (!instance->isDone) {
+                instance->solution = tspSolve(&instance->tsp, instance->maxTourCost, nThreads, placement);
+                instance->isDone = true;
+            }
+            _printReady(window, nInstances, &nPrinted, &nFailed);
+        }
+        nSolved += nInstances;
+    }
+    execTime += omp_get_wtime();
+
+    LOG("nInstances = %d", nSolved);
+    fprintf(stderr, "%.1fs (%d instances, %d failed, %.1f instances/s)\n", execTime, nSolved, nFailed,
+            nSolved / execTime);
+    free(window);
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        printf("Usage: ./tsp <cities_file> <max_value>\n");
-        exit(1);
+    const struct option options[] = {
+        {"threads", required_argument, NULL, 't'},
+        {"affinity", required_argument, NULL, 'a'},
+        {"batch", no_argument, NULL, 'b'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int nThreads = threadDefaultCount();
+    threadPolicy_t policy = THREAD_POLICY_NONE;
+    bool batch = false;
+    int option;
+    while ((option = getopt_long(argc, argv, "t:a:b", options, NULL)) != -1) {
+        switch (option) {
+        case 't':
+            nThreads = atoi(optarg);
+            break;
+        case 'a':
+            if (!threadParsePolicy(optarg, &policy))
+                printUsage();
+            break;
+        case 'b':
+            batch = true;
+            break;
+        default:
+            printUsage();
+        }
+    }
+
+    int nArgs = argc - optind;
+    if (nThreads < 1 || (batch && nArgs > 1) || (!batch && nArgs != 2))
+        printUsage();
+
+    LOG("nThreads = %d", nThreads);
+    threadPlacement_t* placement = threadPlacementCreate(policy);
+
+    if (batch) {
+        FILE* manifestFile = (nArgs == 1 ? openFile(argv[optind], "r") : stdin);
+        solveBatch(manifestFile, nThreads, placement);
+        if (manifestFile != stdin)
+            fclose(manifestFile);
+        threadPlacementDestroy(placement);
+        return 0;
     }
 
-    const char* inPath = argv[1];
-    double maxTourCost = atoi(argv[2]);
+    const char* inPath = argv[optind];
+    double maxTourCost = atoi(argv[optind + 1]);
     LOG("inPath = %s", inPath);
     LOG("maxTourCost = %f", maxTourCost);
-    tsp_t tsp = parseInput(inPath);
+    tsp_t tsp;
+    if (!parseInput(inPath, &tsp))
+        exit(1);
     DEBUG(tspPrint(&tsp));
 
     double execTime = -omp_get_wtime();
-    tspSolution_t* solution = tspSolve(&tsp, maxTourCost);
+    tspSolution_t* solution = tspSolve(&tsp, maxTourCost, nThreads, placement);
     execTime += omp_get_wtime();
 
     fprintf(stderr, "%.1fs\n", execTime);
@@ -63,5 +236,6 @@ int main(int argc, char* argv[]) {
 
     tspSolutionDestroy(solution);
     tspDestroy(&tsp);
+    threadPlacementDestroy(placement);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "tspHeuristic.h"
+#include <math.h>
+#include <string.h>
+
+#define HEURISTIC_EPSILON 1e-9
+
+static inline double _edgeCost(const tsp_t* tsp, int city1, int city2) {
+    return (tspIsNeighbour(tsp, city1, city2) ? tsp->roadCosts[city1][city2] : INFINITY);
+}
+
+// the partial tour is extended with the nearest unvisited city until every city is in it
+static bool _greedyCompletion(const tsp_t* tsp, const tspNode_t* node, char* tour) {
+    bool visited[MAX_CITIES] = {false};
+    for (int i = 0; i < node->length; i++) {
+        tour[i] = node->tour[i];
+        visited[(int)node->tour[i]] = true;
+    }
+
+    for (int i = node->length; i < tsp->nCities; i++) {
+        int currentCity = tour[i - 1];
+        int nextCity = -1;
+        for (int city = 0; city < tsp->nCities; city++) {
+            if (!visited[city] && tspIsNeighbour(tsp, currentCity, city) &&
+                (nextCity < 0 || tsp->roadCosts[currentCity][city] < tsp->roadCosts[currentCity][nextCity]))
+                nextCity = city;
+        }
+        if (nextCity < 0)
+            return false;
+        tour[i] = nextCity;
+        visited[nextCity] = true;
+    }
+    return tspIsNeighbour(tsp, tour[tsp->nCities - 1], 0);
+}
+
+static void _reverse(char* tour, int first, int last) {
+    for (; first < last; first++, last--) {
+        char city = tour[first];
+        tour[first] = tour[last];
+        tour[last] = city;
+    }
+}
+
+static bool _twoOpt(const tsp_t* tsp, char* tour) {
+    int nCities = tsp->nCities;
+    for (int i = 1; i < nCities - 1; i++) {
+        for (int j = i + 1; j < nCities; j++) {
+            int city1 = tour[i - 1], city2 = tour[i], city3 = tour[j], city4 = tour[(j + 1) % nCities];
+            double delta = _edgeCost(tsp, city1, city3) + _edgeCost(tsp, city2, city4) -
+                           tsp->roadCosts[city1][city2] - tsp->roadCosts[city3][city4];
+            if (delta < -HEURISTIC_EPSILON) {
+                _reverse(tour, i, j);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// the segment is placed right after the given position (the first city of the tour never moves)
+static void _moveSegment(char* tour, int nCities, int first, int length, int position) {
+    char moved[MAX_CITIES];
+    int nMoved = 0;
+    for (int i = 0; i < nCities; i++) {
+        if (i >= first && i < first + length)
+            continue;
+        moved[nMoved++] = tour[i];
+        if (i == position)
+            for (int j = 0; j < length; j++)
+                moved[nMoved++] = tour[first + j];
+    }
+    memcpy(tour, moved, nCities);
+}
+
+static bool _orOpt(const tsp_t* tsp, char* tour) {
+    int nCities = tsp->nCities;
+    for (int length = 1; length <= HEURISTIC_OR_OPT_SEGMENT; length++) {
+        for (int first = 1; first + length <= nCities; first++) {
+            int prevCity = tour[first - 1], firstCity = tour[first];
+            int lastCity = tour[first + length - 1], nextCity = tour[(first + length) % nCities];
+            double gain = tsp->roadCosts[prevCity][firstCity] + tsp->roadCosts[lastCity][nextCity] -
+                          _edgeCost(tsp, prevCity, nextCity);
+
+            for (int position = 0; position < nCities; position++) {
+                if (position >= first - 1 && position < first + length)
+                    continue;
+                int city1 = tour[position], city2 = tour[(position + 1) % nCities];
+                double delta = _edgeCost(tsp, city1, firstCity) + _edgeCost(tsp, lastCity, city2) -
+                               tsp->roadCosts[city1][city2] - gain;
+                if (delta < -HEURISTIC_EPSILON) {
+                    _moveSegment(tour, nCities, first, length, position);
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// completes the node greedily and improves the tour with 2-opt and Or-opt moves, the result is a final node
+bool tspHeuristicTour(const tsp_t* tsp, const tspNode_t* node, tspNode_t* finalNode) {
+    char* tour = finalNode->tour;
+    if (!_greedyCompletion(tsp, node, tour))
+        return false;
+
+    int nMoves = 0;
+    while (nMoves < HEURISTIC_MAX_MOVES && (_twoOpt(tsp, tour) || _orOpt(tsp, tour)))
+        nMoves++;
+
+    // the cost is summed in tour order, like the search does, so the same tour always gets the same priority
+    double cost = 0;
+    unsigned long long visited = 1;
+    for (int i = 1; i < tsp->nCities; i++) {
+        cost += tsp->roadCosts[(int)tour[i - 1]][(int)tour[i]];
+        visited |= 1ULL << tour[i];
+    }
+    finalNode->cost = cost;
+    finalNode->lb = cost;
+    finalNode->priority = cost * MAX_CITIES + tour[tsp->nCities - 1];
+    finalNode->length = tsp->nCities;
+    finalNode->sibling = 0;
+    finalNode->visited = visited;
+    return true;
+}
@@ -0,0 +1,13 @@
+#ifndef __TSP__TSP_HEURISTIC_H__
+#define __TSP__TSP_HEURISTIC_H__
+
+#include "include.h"
+#include "tsp.h"
+#include "tspNode.h"
+
+#define HEURISTIC_MAX_MOVES 1024
+#define HEURISTIC_OR_OPT_SEGMENT 3
+
+bool tspHeuristicTour(const tsp_t* tsp, const tspNode_t* node, tspNode_t* finalNode);
+
+#endif // __TSP__TSP_HEURISTIC_H__
@@ -0,0 +1,102 @@
+#include "tspIncumbent.h"
+#include <omp.h>
+
+#define INCUMBENT_IS_LOCKED(VERSION) ((VERSION)&1)
+
+typedef struct {
+    unsigned long version;
+    double cost;
+    double priority;
+} CACHE_ALIGNED tspIncumbentCache_t;
+
+struct _tspIncumbent {
+    CACHE_ALIGNED double priority;
+    CACHE_ALIGNED unsigned long version;
+    tspSolution_t solution;
+    int nThreads;
+    tspIncumbentCache_t* caches;
+};
+
+tspIncumbent_t* tspIncumbentCreate(double maxTourCost, int nThreads) {
+    tspIncumbent_t* incumbent = NULL;
+    posix_memalign((void**)&incumbent, CACHE_LINE_SIZE, sizeof(tspIncumbent_t));
+    incumbent->solution.hasSolution = false;
+    incumbent->solution.cost = maxTourCost;
+    incumbent->solution.priority = maxTourCost * MAX_CITIES + MAX_CITIES - 1;
+    incumbent->priority = incumbent->solution.priority;
+    incumbent->version = 0;
+
+    incumbent->nThreads = nThreads;
+    posix_memalign((void**)&incumbent->caches, CACHE_LINE_SIZE, nThreads * sizeof(tspIncumbentCache_t));
+    for (int i = 0; i < nThreads; i++) {
+        incumbent->caches[i].version = incumbent->version;
+        incumbent->caches[i].cost = incumbent->solution.cost;
+        incumbent->caches[i].priority = incumbent->solution.priority;
+    }
+    return incumbent;
+}
+
+void tspIncumbentDestroy(tspIncumbent_t* incumbent) {
+    free(incumbent->caches);
+    free(incumbent);
+}
+
+static void _publish(tspIncumbent_t* incumbent, const tspNode_t* finalNode, double cost, double priority) {
+    unsigned long version = __atomic_load_n(&incumbent->version, __ATOMIC_RELAXED);
+    while (INCUMBENT_IS_LOCKED(version) || !__atomic_compare_exchange_n(&incumbent->version, &version, version + 1,
+                                                                        true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        version = __atomic_load_n(&incumbent->version, __ATOMIC_RELAXED);
+
+    // writers may publish out of order, so only the best tour is kept
+    tspSolution_t* solution = &incumbent->solution;
+    if (priority < solution->priority) {
+        tspNodeCopyTour(finalNode, solution->tour);
+        solution->hasSolution = true;
+        __atomic_store(&solution->cost, &cost, __ATOMIC_RELAXED);
+        __atomic_store(&solution->priority, &priority, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&incumbent->version, version + 2, __ATOMIC_RELEASE);
+}
+
+bool tspIncumbentUpdate(tspIncumbent_t* incumbent, const tspNode_t* finalNode, double cost, double priority) {
+    double bestPriority;
+    __atomic_load(&incumbent->priority, &bestPriority, __ATOMIC_RELAXED);
+    do {
+        if (priority >= bestPriority)
+            return false;
+    } while (!__atomic_compare_exchange(&incumbent->priority, &bestPriority, &priority, true, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_RELAXED));
+
+    _publish(incumbent, finalNode, cost, priority);
+    return true;
+}
+
+tspSolution_t* tspIncumbentSolution(tspIncumbent_t* incumbent) {
+    tspSolution_t* solution = (tspSolution_t*)malloc(sizeof(tspSolution_t));
+    *solution = incumbent->solution;
+    return solution;
+}
+
+// the cached bound is only refreshed when a new tour was published and no writer holds the buffer
+static const tspIncumbentCache_t* _threadCache(tspIncumbent_t* incumbent) {
+    tspIncumbentCache_t* cache = &incumbent->caches[omp_get_thread_num()];
+    unsigned long version = __atomic_load_n(&incumbent->version, __ATOMIC_ACQUIRE);
+    if (version == cache->version || INCUMBENT_IS_LOCKED(version))
+        return cache;
+
+    double cost, priority;
+    __atomic_load(&incumbent->solution.cost, &cost, __ATOMIC_RELAXED);
+    __atomic_load(&incumbent->solution.priority, &priority, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&incumbent->version, __ATOMIC_RELAXED) == version) {
+        cache->version = version;
+        cache->cost = cost;
+        cache->priority = priority;
+    }
+    return cache;
+}
+
+double tspIncumbentCost(tspIncumbent_t* incumbent) { return _threadCache(incumbent)->cost; }
+
+double tspIncumbentPriority(tspIncumbent_t* incumbent) { return _threadCache(incumbent)->priority; }
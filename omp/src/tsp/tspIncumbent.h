@@ -0,0 +1,19 @@
+#ifndef __TSP__TSP_INCUMBENT_H__
+#define __TSP__TSP_INCUMBENT_H__
+
+#include "include.h"
+#include "tspNode.h"
+#include "tspSolver.h"
+
+typedef struct _tspIncumbent tspIncumbent_t;
+
+tspIncumbent_t* tspIncumbentCreate(double maxTourCost, int nThreads);
+void tspIncumbentDestroy(tspIncumbent_t* incumbent);
+
+bool tspIncumbentUpdate(tspIncumbent_t* incumbent, const tspNode_t* finalNode, double cost, double priority);
+tspSolution_t* tspIncumbentSolution(tspIncumbent_t* incumbent);
+
+double tspIncumbentCost(tspIncumbent_t* incumbent);
+double tspIncumbentPriority(tspIncumbent_t* incumbent);
+
+#endif // __TSP__TSP_INCUMBENT_H__
@@ -8,8 +8,13 @@ typedef struct _tspLoadBalancer tspLoadBalancer_t;
 
 tspLoadBalancer_t* tspLoadBalancerCreate(int nThreads);
 void tspLoadBalancerDestroy(tspLoadBalancer_t* tspLoadBalancer);
+void tspLoadBalancerInitThread(tspLoadBalancer_t* tspLoadBalancer);
 
-tspNode_t* tspLoadBalancerPop(tspLoadBalancer_t* tspLoadBalancer, double* solutionPriority);
+tspNode_t* tspLoadBalancerPop(tspLoadBalancer_t* tspLoadBalancer, double solutionPriority);
 tspNode_t* tspLoadBalancerPush(tspLoadBalancer_t* tspLoadBalancer, tspNode_t* node);
+void tspLoadBalancerPushBatch(tspLoadBalancer_t* tspLoadBalancer, tspNode_t** nodes, int nNodes);
+
+bool tspLoadBalancerIsTerminated(tspLoadBalancer_t* tspLoadBalancer);
+bool tspLoadBalancerSample(tspLoadBalancer_t* tspLoadBalancer, unsigned int* seed, tspNode_t* node);
 
 #endif // __TSP__TSP_LOAD_BALANCER_H__
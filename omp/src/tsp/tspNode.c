@@ -1,11 +1,13 @@
 #include "tspNode.h"
+#include "tspNodePool.h"
 
 tspNode_t* tspNodeCreate(double cost, double lb, int length, int currentCity) {
-    tspNode_t* node = (tspNode_t*)malloc(sizeof(tspNode_t));
+    tspNode_t* node = tspNodePoolAlloc();
     node->cost = cost;
     node->lb = lb;
     node->priority = lb * MAX_CITIES + currentCity;
     node->length = length;
+    node->sibling = 0;
     node->tour[node->length - 1] = currentCity;
     node->visited = 0x00000001 << currentCity;
     return node;
@@ -19,7 +21,7 @@ tspNode_t* tspNodeCreateExt(const tspNode_t* parent, double cost, double lb, int
 }
 
 void tspNodeDestroy(tspNode_t* node) {
-    free(node);
+    tspNodePoolFree(node);
     node = NULL;
 }
 
@@ -0,0 +1,201 @@
+#include "tspNodePool.h"
+#include <omp.h>
+#include <stddef.h>
+
+#define POOL_SLAB_SIZE 1024
+#define POOL_REMOTE_BATCH 64
+
+typedef struct _poolBlock {
+    struct _threadPool* owner;
+    struct _poolBlock* next;
+    tspNode_t node;
+} poolBlock_t;
+
+typedef struct _poolSlab {
+    struct _poolSlab* next;
+    poolBlock_t blocks[];
+} poolSlab_t;
+
+typedef struct {
+    poolBlock_t* head;
+    poolBlock_t* tail;
+    int size;
+} poolBatch_t;
+
+typedef struct _threadPool {
+    CACHE_ALIGNED poolBlock_t* remoteFree;
+    CACHE_ALIGNED tspNodePool_t* nodePool;
+    int threadNum;
+    poolBlock_t* localFree;
+    poolSlab_t* slabs;
+    poolBatch_t* batches;
+    unsigned long nAllocs;
+    unsigned long nRemoteFrees;
+    unsigned long nSlabs;
+} threadPool_t;
+
+struct _tspNodePool {
+    int nThreads;
+    double startTime;
+    threadPool_t** threads;
+};
+
+static __thread threadPool_t* _localPool = NULL;
+
+static threadPool_t* _threadPoolCreate(tspNodePool_t* nodePool, int threadNum) {
+    threadPool_t* threadPool = NULL;
+    posix_memalign((void**)&threadPool, CACHE_LINE_SIZE, sizeof(threadPool_t));
+    threadPool->remoteFree = NULL;
+    threadPool->nodePool = nodePool;
+    threadPool->threadNum = threadNum;
+    threadPool->localFree = NULL;
+    threadPool->slabs = NULL;
+    threadPool->batches = (poolBatch_t*)calloc(nodePool->nThreads, sizeof(poolBatch_t));
+    threadPool->nAllocs = 0;
+    threadPool->nRemoteFrees = 0;
+    threadPool->nSlabs = 0;
+    return threadPool;
+}
+
+static void _threadPoolDestroy(threadPool_t* threadPool) {
+    while (threadPool->slabs != NULL) {
+        poolSlab_t* slab = threadPool->slabs;
+        threadPool->slabs = slab->next;
+        free(slab);
+    }
+    free(threadPool->batches);
+    free(threadPool);
+}
+
+#ifdef __STATS__
+static void _logStats(tspNodePool_t* nodePool) {
+    double execTime = omp_get_wtime() - nodePool->startTime;
+    unsigned long nAllocs = 0, nRemoteFrees = 0, nSlabs = 0;
+    for (int i = 0; i < nodePool->nThreads; i++) {
+        nAllocs += nodePool->threads[i]->nAllocs;
+        nRemoteFrees += nodePool->threads[i]->nRemoteFrees;
+        nSlabs += nodePool->threads[i]->nSlabs;
+    }
+    STATS_LOG("node pool allocations = %lu (%.1f M/s)", nAllocs, nAllocs / execTime / 1e6);
+    STATS_LOG("node pool remote frees = %lu (%.1f%%)", nRemoteFrees,
+              (nAllocs > 0 ? 100.0 * nRemoteFrees / nAllocs : 0.0));
+    STATS_LOG("node pool slabs = %lu (%.1f MB)", nSlabs,
+              nSlabs * (sizeof(poolSlab_t) + POOL_SLAB_SIZE * sizeof(poolBlock_t)) / (1024.0 * 1024.0));
+}
+#endif
+
+tspNodePool_t* tspNodePoolCreate(int nThreads) {
+    tspNodePool_t* nodePool = (tspNodePool_t*)malloc(sizeof(tspNodePool_t));
+    nodePool->nThreads = nThreads;
+    nodePool->startTime = omp_get_wtime();
+    nodePool->threads = (threadPool_t**)calloc(nThreads, sizeof(threadPool_t*));
+    return nodePool;
+}
+
+void tspNodePoolDestroy(tspNodePool_t* nodePool) {
+    STATS(_logStats(nodePool));
+    for (int i = 0; i < nodePool->nThreads; i++)
+        _threadPoolDestroy(nodePool->threads[i]);
+    free(nodePool->threads);
+    free(nodePool);
+}
+
+// the pool of each thread is created and first touched by the thread itself, keeping its slabs in local memory
+void tspNodePoolInitThread(tspNodePool_t* nodePool) {
+    int threadNum = omp_get_thread_num();
+    nodePool->threads[threadNum] = _threadPoolCreate(nodePool, threadNum);
+    _localPool = nodePool->threads[threadNum];
+}
+
+// the threads outlive the pool, so each one forgets its own pool before the pool is destroyed
+void tspNodePoolFinishThread(tspNodePool_t* nodePool) {
+    tspNodePoolFlush();
+    if (_localPool != NULL && _localPool->nodePool == nodePool)
+        _localPool = NULL;
+}
+
+static inline poolBlock_t* _nodeBlock(tspNode_t* node) {
+    return (poolBlock_t*)((char*)node - offsetof(poolBlock_t, node));
+}
+
+static void _allocateSlab(threadPool_t* threadPool) {
+    poolSlab_t* slab = (poolSlab_t*)malloc(sizeof(poolSlab_t) + POOL_SLAB_SIZE * sizeof(poolBlock_t));
+    for (int i = 0; i < POOL_SLAB_SIZE; i++) {
+        slab->blocks[i].owner = threadPool;
+        slab->blocks[i].next = (i + 1 < POOL_SLAB_SIZE ? &slab->blocks[i + 1] : NULL);
+    }
+    slab->next = threadPool->slabs;
+    threadPool->slabs = slab;
+    threadPool->localFree = &slab->blocks[0];
+    STATS(threadPool->nSlabs++);
+}
+
+static void _pushRemote(threadPool_t* owner, poolBlock_t* head, poolBlock_t* tail) {
+    poolBlock_t* remoteFree = __atomic_load_n(&owner->remoteFree, __ATOMIC_RELAXED);
+    do {
+        tail->next = remoteFree;
+    } while (!__atomic_compare_exchange_n(&owner->remoteFree, &remoteFree, head, true, __ATOMIC_RELEASE,
+                                          __ATOMIC_RELAXED));
+}
+
+static void _flushBatch(threadPool_t* owner, poolBatch_t* batch) {
+    _pushRemote(owner, batch->head, batch->tail);
+    batch->head = NULL;
+    batch->tail = NULL;
+    batch->size = 0;
+}
+
+// the batches that never filled up are handed back when the thread runs out of work, so their owners can reuse them
+void tspNodePoolFlush() {
+    threadPool_t* threadPool = _localPool;
+    if (threadPool == NULL)
+        return;
+    for (int i = 0; i < threadPool->nodePool->nThreads; i++)
+        if (threadPool->batches[i].size > 0)
+            _flushBatch(threadPool->nodePool->threads[i], &threadPool->batches[i]);
+}
+
+tspNode_t* tspNodePoolAlloc() {
+    threadPool_t* threadPool = _localPool;
+    if (threadPool == NULL) {
+        poolBlock_t* block = (poolBlock_t*)malloc(sizeof(poolBlock_t));
+        block->owner = NULL;
+        return &block->node;
+    }
+
+    // the blocks returned by other threads are only claimed once the local ones run out, all at once
+    if (threadPool->localFree == NULL)
+        threadPool->localFree = __atomic_exchange_n(&threadPool->remoteFree, NULL, __ATOMIC_ACQUIRE);
+    if (threadPool->localFree == NULL)
+        _allocateSlab(threadPool);
+
+    poolBlock_t* block = threadPool->localFree;
+    threadPool->localFree = block->next;
+    STATS(threadPool->nAllocs++);
+    return &block->node;
+}
+
+void tspNodePoolFree(tspNode_t* node) {
+    poolBlock_t* block = _nodeBlock(node);
+    threadPool_t* owner = block->owner;
+    threadPool_t* threadPool = _localPool;
+
+    if (owner == NULL) {
+        free(block);
+    } else if (owner == threadPool) {
+        block->next = threadPool->localFree;
+        threadPool->localFree = block;
+    } else if (threadPool == NULL || threadPool->nodePool != owner->nodePool) {
+        _pushRemote(owner, block, block);
+    } else {
+        poolBatch_t* batch = &threadPool->batches[owner->threadNum];
+        block->next = batch->head;
+        batch->head = block;
+        if (batch->tail == NULL)
+            batch->tail = block;
+        STATS(threadPool->nRemoteFrees++);
+
+        if (++batch->size == POOL_REMOTE_BATCH)
+            _flushBatch(owner, batch);
+    }
+}
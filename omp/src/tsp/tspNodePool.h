@@ -0,0 +1,18 @@
+#ifndef __TSP__TSP_NODE_POOL_H__
+#define __TSP__TSP_NODE_POOL_H__
+
+#include "include.h"
+#include "tspNode.h"
+
+typedef struct _tspNodePool tspNodePool_t;
+
+tspNodePool_t* tspNodePoolCreate(int nThreads);
+void tspNodePoolDestroy(tspNodePool_t* nodePool);
+void tspNodePoolInitThread(tspNodePool_t* nodePool);
+void tspNodePoolFinishThread(tspNodePool_t* nodePool);
+void tspNodePoolFlush();
+
+tspNode_t* tspNodePoolAlloc();
+void tspNodePoolFree(tspNode_t* node);
+
+#endif // __TSP__TSP_NODE_POOL_H__
@@ -1,13 +1,38 @@
 #include "tspSolver.h"
+#include "tspHeuristic.h"
+#include "tspIncumbent.h"
 #include "tspLoadBalancer.h"
 #include "tspNode.h"
+#include "tspNodePool.h"
+#include "utils/queue.h"
 #include <math.h>
 #include <omp.h>
+#include <sched.h>
+
+#define SOLVER_RAMP_UP_NODES 16
+
+#ifdef __PRIMAL_HEURISTIC__
+#define SOLVER_HEURISTIC_THREADS 1
+#else
+#define SOLVER_HEURISTIC_THREADS 0
+#endif
 
 typedef struct {
     const tsp_t* tsp;
-    tspSolution_t* solution;
+    tspIncumbent_t* incumbent;
     tspLoadBalancer_t* loadBalancer;
+    tspNodePool_t* nodePool;
+    tspNode_t** frontier;
+    int nFrontier;
+    int nThreads;
+    int nBusyThreads;
+    double startTime;
+    double rampUpTime;
+    double utilizationTime;
+    unsigned long nExpanded;
+    unsigned long nCreated;
+    unsigned long nHeuristicTours;
+    unsigned long nHeuristicImprovements;
 } tspSolverData_t;
 
 tspSolution_t* tspSolutionCreate(double maxTourCost) {
@@ -24,6 +49,22 @@ static inline bool _isCityInTour(const tspNode_t* node, int cityNumber) {
     return node->visited & (0x00000001 << cityNumber);
 }
 
+static inline bool _isCanonicalOrientation(const tsp_t* tsp, const tspNode_t* parent, int nextCity) {
+#ifdef __SYMMETRY_BREAKING__
+    // keeps the orientation whose last city is lower than the first, i.e. the one with the lower priority
+    if (parent->length + 1 >= tsp->nCities)
+        return true;
+    int firstCity = (parent->length == 1 ? nextCity : parent->tour[1]);
+    unsigned long long visited = parent->visited | (1ULL << nextCity);
+    return (~visited & ((1ULL << firstCity) - 1)) != 0;
+#else
+    (void)tsp;
+    (void)parent;
+    (void)nextCity;
+    return true;
+#endif
+}
+
 static double _calculateInitialLb(const tsp_t* tsp) {
     double sum = 0.0;
     for (int i = 0; i < tsp->nCities; i++)
@@ -43,68 +84,298 @@ static double _calculateLb(const tsp_t* tsp, const tspNode_t* node, int nextCity
     return node->lb + costFromTo - (costFrom + costTo) / 2;
 }
 
-static void _updateBestTour(tspSolverData_t* solverData, const tspNode_t* finalNode) {
+static bool _updateBestTour(tspSolverData_t* solverData, const tspNode_t* finalNode) {
     const tsp_t* tsp = solverData->tsp;
-    tspSolution_t* solution = solverData->solution;
     int currentCity = tspNodeCurrentCity(finalNode);
     double cost = finalNode->cost + tsp->roadCosts[currentCity][0];
     double priority = cost * MAX_CITIES + currentCity;
-#pragma omp critical(solution)
-    if (priority < solution->priority) {
-        tspNodeCopyTour(finalNode, solution->tour);
-        solution->hasSolution = true;
-        solution->cost = cost;
-        solution->priority = cost * MAX_CITIES + solution->tour[tsp->nCities - 1];
-    }
+    return tspIncumbentUpdate(solverData->incumbent, finalNode, cost, priority);
 }
 
-static void _visitNeighbors(tspSolverData_t* solverData, const tspNode_t* parent) {
+static int _expandNode(tspSolverData_t* solverData, const tspNode_t* parent, tspNode_t** children) {
     const tsp_t* tsp = solverData->tsp;
     int parentCurrentCity = tspNodeCurrentCity(parent);
+    double bestCost = tspIncumbentCost(solverData->incumbent);
+    int nChildren = 0;
     for (int cityNumber = 0; cityNumber < tsp->nCities; cityNumber++) {
-        if (tspIsNeighbour(tsp, parentCurrentCity, cityNumber) && !_isCityInTour(parent, cityNumber)) {
+        if (tspIsNeighbour(tsp, parentCurrentCity, cityNumber) && !_isCityInTour(parent, cityNumber) &&
+            _isCanonicalOrientation(tsp, parent, cityNumber)) {
             double lb = _calculateLb(tsp, parent, cityNumber);
-            if (lb > solverData->solution->cost)
+            if (lb > bestCost)
                 continue;
             double cost = parent->cost + tsp->roadCosts[parentCurrentCity][cityNumber];
             tspNode_t* nextNode = tspNodeCreateExt(parent, cost, lb, cityNumber);
-            tspLoadBalancerPush(solverData->loadBalancer, nextNode);
+            STATS(__atomic_fetch_add(&solverData->nCreated, 1, __ATOMIC_RELAXED));
+            int i = nChildren++;
+            for (; i > 0 && children[i - 1]->priority > nextNode->priority; i--)
+                children[i] = children[i - 1];
+            children[i] = nextNode;
+        }
+    }
+    return nChildren;
+}
+
+#ifdef __LAZY_EXPANSION__
+typedef struct {
+    int city;
+    double lb;
+    double priority;
+} tspChild_t;
+
+static int _sortedChildren(const tsp_t* tsp, const tspNode_t* parent, tspChild_t* children) {
+    int parentCurrentCity = tspNodeCurrentCity(parent);
+    int nChildren = 0;
+    for (int cityNumber = 0; cityNumber < tsp->nCities; cityNumber++) {
+        if (tspIsNeighbour(tsp, parentCurrentCity, cityNumber) && !_isCityInTour(parent, cityNumber) &&
+            _isCanonicalOrientation(tsp, parent, cityNumber)) {
+            double lb = _calculateLb(tsp, parent, cityNumber);
+            tspChild_t child = {cityNumber, lb, lb * MAX_CITIES + cityNumber};
+            int i = nChildren++;
+            for (; i > 0 && children[i - 1].priority > child.priority; i--)
+                children[i] = children[i - 1];
+            children[i] = child;
         }
     }
+    return nChildren;
 }
 
-static void _processNode(tspSolverData_t* solverData, tspNode_t* node) {
+static int _nextSibling(const tspChild_t* children, int nChildren, int sibling, double bestCost) {
+    while (sibling < nChildren && children[sibling].lb > bestCost)
+        sibling++;
+    return sibling;
+}
+
+// only the best pending child is created, the parent is pushed back as a cursor to its next sibling
+static bool _visitNeighbors(tspSolverData_t* solverData, tspNode_t* parent) {
     const tsp_t* tsp = solverData->tsp;
-    if ((node->length == tsp->nCities) && tspIsNeighbour(tsp, tspNodeCurrentCity(node), 0))
+    int parentCurrentCity = tspNodeCurrentCity(parent);
+    tspChild_t children[MAX_CITIES];
+    int nChildren = _sortedChildren(tsp, parent, children);
+    double bestCost = tspIncumbentCost(solverData->incumbent);
+
+    int sibling = _nextSibling(children, nChildren, parent->sibling, bestCost);
+    if (sibling == nChildren)
+        return false;
+
+    const tspChild_t* child = &children[sibling];
+    double cost = parent->cost + tsp->roadCosts[parentCurrentCity][child->city];
+    tspNode_t* nodes[2] = {tspNodeCreateExt(parent, cost, child->lb, child->city), parent};
+    STATS(__atomic_fetch_add(&solverData->nCreated, 1, __ATOMIC_RELAXED));
+
+    sibling = _nextSibling(children, nChildren, sibling + 1, bestCost);
+    if (sibling == nChildren) {
+        tspLoadBalancerPushBatch(solverData->loadBalancer, nodes, 1);
+        return false;
+    }
+
+    parent->sibling = sibling;
+    parent->priority = children[sibling].priority;
+    tspLoadBalancerPushBatch(solverData->loadBalancer, nodes, 2);
+    return true;
+}
+#else
+// the children are staged sorted by priority and handed to the load balancer at once
+static bool _visitNeighbors(tspSolverData_t* solverData, tspNode_t* parent) {
+    tspNode_t* children[MAX_CITIES];
+    int nChildren = _expandNode(solverData, parent, children);
+    tspLoadBalancerPushBatch(solverData->loadBalancer, children, nChildren);
+    return false;
+}
+#endif
+
+static bool _processNode(tspSolverData_t* solverData, tspNode_t* node) {
+    const tsp_t* tsp = solverData->tsp;
+    STATS(__atomic_fetch_add(&solverData->nExpanded, 1, __ATOMIC_RELAXED));
+    if ((node->length == tsp->nCities) && tspIsNeighbour(tsp, tspNodeCurrentCity(node), 0)) {
         _updateBestTour(solverData, node);
+        return false;
+    }
+    return _visitNeighbors(solverData, node);
+}
+
+static int __tspNodeCmpFun(void* el1, void* el2) {
+    tspNode_t* node1 = (tspNode_t*)el1;
+    tspNode_t* node2 = (tspNode_t*)el2;
+    return (node2->priority < node1->priority ? 1 : 0);
+}
+
+static int __tspNodeBreadthFirstCmpFun(void* el1, void* el2) {
+    tspNode_t* node1 = (tspNode_t*)el1;
+    tspNode_t* node2 = (tspNode_t*)el2;
+    if (node1->length != node2->length)
+        return (node2->length < node1->length ? 1 : 0);
+    return (node2->priority < node1->priority ? 1 : 0);
+}
+
+static void __tspNodeDestroyFun(void* el) {
+    tspNode_t* node = (tspNode_t*)el;
+    tspNodeDestroy(node);
+}
+
+// the shallowest nodes are expanded first, so the initial subproblems are few levels deep and similar in size
+static void _rampUp(tspSolverData_t* solverData) {
+    const tsp_t* tsp = solverData->tsp;
+    priorityQueue_t* frontier = queueCreate(__tspNodeBreadthFirstCmpFun);
+    queuePush(frontier, tspNodeCreate(0, _calculateInitialLb(tsp), 1, 0));
+
+    while (queueSize(frontier) > 0 && queueSize(frontier) < (size_t)(SOLVER_RAMP_UP_NODES * solverData->nThreads)) {
+        tspNode_t* node = queuePop(frontier);
+        STATS(solverData->nExpanded++);
+        if (node->length == tsp->nCities) {
+            if (tspIsNeighbour(tsp, tspNodeCurrentCity(node), 0))
+                _updateBestTour(solverData, node);
+        } else if (node->priority <= tspIncumbentPriority(solverData->incumbent)) {
+            tspNode_t* children[MAX_CITIES];
+            int nChildren = _expandNode(solverData, node, children);
+            for (int i = 0; i < nChildren; i++)
+                queuePush(frontier, children[i]);
+        }
+        tspNodeDestroy(node);
+    }
+
+    // the frontier is sorted by priority, so each thread gets both promising and unpromising subproblems
+    double solutionPriority = tspIncumbentPriority(solverData->incumbent);
+    priorityQueue_t* sorted = queueCreate(__tspNodeCmpFun);
+    while (queueSize(frontier) > 0)
+        queuePush(sorted, queuePop(frontier));
+    solverData->frontier = (tspNode_t**)malloc(queueSize(sorted) * sizeof(tspNode_t*));
+    solverData->nFrontier = 0;
+    while (queueSize(sorted) > 0) {
+        tspNode_t* node = queuePop(sorted);
+        if (node->priority <= solutionPriority)
+            solverData->frontier[solverData->nFrontier++] = node;
+        else
+            tspNodeDestroy(node);
+    }
+    queueDestroy(sorted, NULL);
+    queueDestroy(frontier, __tspNodeDestroyFun);
+}
+
+// the sorted frontier is dealt in a snake order (0, 1, .., n-1, n-1, .., 0, 0, ..), which balances the bounds
+static inline int _frontierOwner(int index, int nThreads) {
+    int round = index % (2 * nThreads);
+    return (round < nThreads ? round : 2 * nThreads - 1 - round);
+}
+
+static void _takeFrontierShare(tspSolverData_t* solverData, int threadNum) {
+    for (int i = 0; i < solverData->nFrontier; i++)
+        if (_frontierOwner(i, solverData->nThreads) == threadNum)
+            tspLoadBalancerPush(solverData->loadBalancer, solverData->frontier[i]);
+}
+
+static void _markBusy(tspSolverData_t* solverData) {
+    if (__atomic_add_fetch(&solverData->nBusyThreads, 1, __ATOMIC_RELAXED) == solverData->nThreads)
+        solverData->utilizationTime = omp_get_wtime() - solverData->startTime;
+}
+
+static void _searchLoop(tspSolverData_t* solverData) {
+    bool isBusy = false;
+    while (true) {
+        tspNode_t* node = tspLoadBalancerPop(solverData->loadBalancer, tspIncumbentPriority(solverData->incumbent));
+        if (node == NULL)
+            break;
+        if (!isBusy) {
+            isBusy = true;
+            _markBusy(solverData);
+        }
+        if (!_processNode(solverData, node))
+            tspNodeDestroy(node);
+    }
+}
+
+// the node is copied out of the frontier, so the heuristic thread never holds work the search threads wait for
+static void _heuristicLoop(tspSolverData_t* solverData) {
+    unsigned int seed = omp_get_thread_num() + 1;
+    tspNode_t node, finalNode;
+    double lastPriority = INFINITY;
+    unsigned long long lastVisited = 0;
+
+    while (!tspLoadBalancerIsTerminated(solverData->loadBalancer)) {
+        if (!tspLoadBalancerSample(solverData->loadBalancer, &seed, &node) ||
+            (node.priority == lastPriority && node.visited == lastVisited)) {
+            sched_yield();
+            continue;
+        }
+
+        lastPriority = node.priority;
+        lastVisited = node.visited;
+        if (!tspHeuristicTour(solverData->tsp, &node, &finalNode))
+            continue;
+        solverData->nHeuristicTours++;
+        solverData->nHeuristicImprovements += _updateBestTour(solverData, &finalNode);
+    }
+}
+
+#ifdef __STATS__
+static void _logStats(tspSolverData_t* solverData) {
+    STATS_LOG("expanded nodes = %lu", solverData->nExpanded);
+    STATS_LOG("created nodes = %lu", solverData->nCreated);
+    STATS_LOG("ramp-up = %.3fms (%d subproblems)", 1e3 * solverData->rampUpTime, solverData->nFrontier);
+    if (solverData->nBusyThreads == solverData->nThreads)
+        STATS_LOG("full utilization after %.3fms", 1e3 * solverData->utilizationTime);
     else
-        _visitNeighbors(solverData, node);
+        STATS_LOG("full utilization never reached (%d busy threads)", solverData->nBusyThreads);
+    if (solverData->nHeuristicTours > 0)
+        STATS_LOG("heuristic tours = %lu (%lu improvements)", solverData->nHeuristicTours,
+                  solverData->nHeuristicImprovements);
 }
+#endif
 
-tspSolution_t* tspSolve(const tsp_t* tsp, double maxTourCost) {
+tspSolution_t* tspSolve(const tsp_t* tsp, double maxTourCost, int nThreads, const threadPlacement_t* placement) {
     tspSolverData_t solverData;
 
-#pragma omp parallel num_threads(6)
+#pragma omp parallel num_threads(nThreads)
     {
+        threadPlacementPin(placement, omp_get_thread_num());
+
 #pragma omp single
         {
             solverData.tsp = tsp;
-            solverData.solution = tspSolutionCreate(maxTourCost);
-            solverData.loadBalancer = tspLoadBalancerCreate(omp_get_num_threads());
-            tspNode_t* startNode = tspNodeCreate(0, _calculateInitialLb(tsp), 1, 0);
-            _processNode(&solverData, startNode);
-            tspNodeDestroy(startNode);
+            // with a single thread there is no one left to search, so the heuristic thread is dropped
+            solverData.nThreads = omp_get_num_threads();
+            if (solverData.nThreads > SOLVER_HEURISTIC_THREADS)
+                solverData.nThreads -= SOLVER_HEURISTIC_THREADS;
+            solverData.incumbent = tspIncumbentCreate(maxTourCost, omp_get_num_threads());
+            solverData.loadBalancer = tspLoadBalancerCreate(solverData.nThreads);
+            solverData.nodePool = tspNodePoolCreate(omp_get_num_threads());
+            solverData.frontier = NULL;
+            solverData.nFrontier = 0;
+            solverData.nBusyThreads = 0;
+            solverData.startTime = omp_get_wtime();
+            solverData.rampUpTime = 0;
+            solverData.utilizationTime = 0;
+            solverData.nExpanded = 0;
+            solverData.nCreated = 0;
+            solverData.nHeuristicTours = 0;
+            solverData.nHeuristicImprovements = 0;
         }
 
-        while (true) {
-            tspNode_t* node = tspLoadBalancerPop(solverData.loadBalancer, &solverData.solution->priority);
-            if (node == NULL)
-                break;
-            _processNode(&solverData, node);
-            tspNodeDestroy(node);
+        bool isHeuristic = (omp_get_thread_num() >= solverData.nThreads);
+        if (!isHeuristic)
+            tspLoadBalancerInitThread(solverData.loadBalancer);
+        tspNodePoolInitThread(solverData.nodePool);
+#pragma omp barrier
+
+#pragma omp single
+        {
+            _rampUp(&solverData);
+            solverData.rampUpTime = omp_get_wtime() - solverData.startTime;
+        }
+
+        if (isHeuristic) {
+            _heuristicLoop(&solverData);
+        } else {
+            _takeFrontierShare(&solverData, omp_get_thread_num());
+            _searchLoop(&solverData);
         }
+        tspNodePoolFinishThread(solverData.nodePool);
     }
 
+    STATS(_logStats(&solverData));
+    free(solverData.frontier);
+    tspSolution_t* solution = tspIncumbentSolution(solverData.incumbent);
+    tspIncumbentDestroy(solverData.incumbent);
     tspLoadBalancerDestroy(solverData.loadBalancer);
-    return solverData.solution;
+    tspNodePoolDestroy(solverData.nodePool);
+    return solution;
 }
@@ -42,6 +42,8 @@ void queueDestroy(priorityQueue_t* queue, void (*delFun)(void*)) {
     free(queue);
 }
 
+size_t queueSize(priorityQueue_t* queue) { return queue->size; }
+
 void* queuePeek(priorityQueue_t* queue) { return queue->buffer[0]; }
 
 void* queuePop(priorityQueue_t* queue) {
@@ -69,4 +71,29 @@ void* queuePush(priorityQueue_t* queue, void* element) {
     }
 
     return element;
-}
\ No newline at end of file
+}
+
+// the kept elements are compacted and the heap is rebuilt bottom-up, which is linear instead of n pushes
+size_t queueFilter(priorityQueue_t* queue, bool (*keepFun)(void*, void*), void* arg, void (*delFun)(void*)) {
+    size_t size = 0;
+    for (size_t i = 0; i < queue->size; i++) {
+        if (keepFun(queue->buffer[i], arg))
+            queue->buffer[size++] = queue->buffer[i];
+        else if (delFun != NULL)
+            delFun(queue->buffer[i]);
+    }
+
+    size_t nRemoved = queue->size - size;
+    queue->size = size;
+    for (size_t i = size / 2; i-- > 0;)
+        _bubble_down(queue, i);
+
+    size_t maxSize = queue->max_size;
+    while (maxSize > QUEUE_INITIAL_SIZE && queue->size * 4 <= maxSize)
+        maxSize /= 2;
+    if (maxSize != queue->max_size) {
+        queue->max_size = maxSize;
+        queue->buffer = realloc(queue->buffer, queue->max_size * sizeof(void*));
+    }
+    return nRemoved;
+}
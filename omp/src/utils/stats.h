@@ -0,0 +1,12 @@
+#ifndef __UTILS__STATS_H__
+#define __UTILS__STATS_H__
+
+#ifdef __STATS__
+#define STATS(X) X
+#define STATS_LOG(X, ...) fprintf(stderr, "[Stats]: " X "\n", __VA_ARGS__)
+#else
+#define STATS(X)
+#define STATS_LOG(X, ...)
+#endif
+
+#endif // __UTILS__STATS_H__
\ No newline at end of file
@@ -0,0 +1,134 @@
+#define _GNU_SOURCE
+#include "threads.h"
+#include <math.h>
+#include <omp.h>
+#include <pthread.h>
+#include <sched.h>
+
+struct _threadPlacement {
+    int nCpus;
+    int* cpus;
+};
+
+typedef struct {
+    int cpu;
+    int package;
+    int packageIndex;
+} threadCpu_t;
+
+static bool _readValues(const char* path, const char* format, void* value1, void* value2) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+        return false;
+    int nValues = fscanf(file, format, value1, value2);
+    fclose(file);
+    return nValues == (value2 == NULL ? 1 : 2);
+}
+
+static int _cgroupCpuQuota() {
+    double quota, period;
+    char quotaStr[32];
+    if (_readValues(THREAD_CGROUP_V2_MAX, "%31s %lf", quotaStr, &period)) {
+        if (strcmp(quotaStr, "max") == 0 || period <= 0)
+            return 0;
+        quota = atof(quotaStr);
+    } else if (!_readValues(THREAD_CGROUP_V1_QUOTA, "%lf", &quota, NULL) ||
+               !_readValues(THREAD_CGROUP_V1_PERIOD, "%lf", &period, NULL) || quota <= 0 || period <= 0) {
+        return 0;
+    }
+    return (int)ceil(quota / period);
+}
+
+int threadDefaultCount() {
+    if (getenv("OMP_NUM_THREADS") != NULL)
+        return omp_get_max_threads();
+
+    int nThreads = omp_get_num_procs();
+    int quota = _cgroupCpuQuota();
+    if (quota > 0 && quota < nThreads)
+        nThreads = quota;
+    return nThreads;
+}
+
+bool threadParsePolicy(const char* name, threadPolicy_t* policy) {
+    if (strcmp(name, "none") == 0)
+        *policy = THREAD_POLICY_NONE;
+    else if (strcmp(name, "compact") == 0)
+        *policy = THREAD_POLICY_COMPACT;
+    else if (strcmp(name, "scatter") == 0)
+        *policy = THREAD_POLICY_SCATTER;
+    else
+        return false;
+    return true;
+}
+
+static int _cmpCompact(const void* el1, const void* el2) {
+    const threadCpu_t* cpu1 = (const threadCpu_t*)el1;
+    const threadCpu_t* cpu2 = (const threadCpu_t*)el2;
+    if (cpu1->package != cpu2->package)
+        return cpu1->package - cpu2->package;
+    return cpu1->cpu - cpu2->cpu;
+}
+
+static int _cmpScatter(const void* el1, const void* el2) {
+    const threadCpu_t* cpu1 = (const threadCpu_t*)el1;
+    const threadCpu_t* cpu2 = (const threadCpu_t*)el2;
+    if (cpu1->packageIndex != cpu2->packageIndex)
+        return cpu1->packageIndex - cpu2->packageIndex;
+    return cpu1->package - cpu2->package;
+}
+
+static int _cpuPackage(int cpu) {
+    char path[128];
+    int package = 0;
+    snprintf(path, sizeof(path), THREAD_CPU_PACKAGE, cpu);
+    _readValues(path, "%d", &package, NULL);
+    return package;
+}
+
+threadPlacement_t* threadPlacementCreate(threadPolicy_t policy) {
+    cpu_set_t allowedCpus;
+    if (policy == THREAD_POLICY_NONE || sched_getaffinity(0, sizeof(allowedCpus), &allowedCpus) != 0)
+        return NULL;
+
+    threadCpu_t* cpus = (threadCpu_t*)malloc(CPU_SETSIZE * sizeof(threadCpu_t));
+    int nCpus = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowedCpus)) {
+            cpus[nCpus].cpu = cpu;
+            cpus[nCpus].package = _cpuPackage(cpu);
+            nCpus++;
+        }
+    }
+
+    qsort(cpus, nCpus, sizeof(threadCpu_t), _cmpCompact);
+    for (int i = 0; i < nCpus; i++)
+        cpus[i].packageIndex = (i > 0 && cpus[i].package == cpus[i - 1].package ? cpus[i - 1].packageIndex + 1 : 0);
+    if (policy == THREAD_POLICY_SCATTER)
+        qsort(cpus, nCpus, sizeof(threadCpu_t), _cmpScatter);
+
+    threadPlacement_t* placement = (threadPlacement_t*)malloc(sizeof(threadPlacement_t));
+    placement->nCpus = nCpus;
+    placement->cpus = (int*)malloc(nCpus * sizeof(int));
+    for (int i = 0; i < nCpus; i++)
+        placement->cpus[i] = cpus[i].cpu;
+    free(cpus);
+    return placement;
+}
+
+void threadPlacementDestroy(threadPlacement_t* placement) {
+    if (placement == NULL)
+        return;
+    free(placement->cpus);
+    free(placement);
+}
+
+void threadPlacementPin(const threadPlacement_t* placement, int threadNum) {
+    if (placement == NULL || placement->nCpus == 0)
+        return;
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(placement->cpus[threadNum % placement->nCpus], &cpuSet);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+}
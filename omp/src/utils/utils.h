@@ -1,6 +1,9 @@
 #ifndef __UTILS__UTILS_H__
 #define __UTILS__UTILS_H__
 
+#define CACHE_LINE_SIZE 64
+#define CACHE_ALIGNED __attribute__((aligned(CACHE_LINE_SIZE)))
+
 #define SWAP(x, y)                                                                                                     \
     void* tmp = x;                                                                                                     \
     x = y;                                                                                                             \
@@ -6,6 +6,7 @@ tspNode_t* tspNodeCreate(double cost, double lb, int length, int currentCity) {
     node->lb = lb;
     node->priority = lb * MAX_CITIES + currentCity;
     node->length = length;
+    node->sibling = 0;
     node->tour[node->length - 1] = currentCity;
     node->visited = 0x00000001 << currentCity;
     return node;
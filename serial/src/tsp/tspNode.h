@@ -9,6 +9,7 @@ typedef struct {
     double lb;
     double priority;
     int length;
+    int sibling;
     char tour[MAX_CITIES];
     unsigned long long visited;
 } tspNode_t;
@@ -3,10 +3,17 @@
 #include "utils/queue.h"
 #include <math.h>
 
+#define PURGE_MIN_NODES 1024
+#define PURGE_MIN_IMPROVEMENT 0.01
+
 typedef struct {
     const tsp_t* tsp;
     tspSolution_t* solution;
     priorityQueue_t* queue;
+    double purgePriority;
+    unsigned long nPurged;
+    unsigned long nExpanded;
+    unsigned long nCreated;
 } tspSolverData_t;
 
 tspSolution_t* tspSolutionCreate(double maxTourCost) {
@@ -30,6 +37,11 @@ static void __tspNodeDestroyFun(void* el) {
     tspNodeDestroy(node);
 }
 
+static bool __tspNodeIsPromisingFun(void* el, void* arg) {
+    tspNode_t* node = (tspNode_t*)el;
+    return node->priority <= *(double*)arg;
+}
+
 static tspNode_t* _getNextNode(priorityQueue_t* queue, double solutionPriority) {
     tspNode_t* node = queuePop(queue);
     if (node != NULL && node->priority > solutionPriority) {
@@ -43,6 +55,22 @@ static inline bool _isCityInTour(const tspNode_t* node, int cityNumber) {
     return node->visited & (0x00000001 << cityNumber);
 }
 
+static inline bool _isCanonicalOrientation(const tsp_t* tsp, const tspNode_t* parent, int nextCity) {
+#ifdef __SYMMETRY_BREAKING__
+    // keeps the orientation whose last city is lower than the first, i.e. the one with the lower priority
+    if (parent->length + 1 >= tsp->nCities)
+        return true;
+    int firstCity = (parent->length == 1 ? nextCity : parent->tour[1]);
+    unsigned long long visited = parent->visited | (1ULL << nextCity);
+    return (~visited & ((1ULL << firstCity) - 1)) != 0;
+#else
+    (void)tsp;
+    (void)parent;
+    (void)nextCity;
+    return true;
+#endif
+}
+
 static double _calculateInitialLb(const tsp_t* tsp) {
     double sum = 0.0;
     for (int i = 0; i < tsp->nCities; i++)
@@ -62,6 +90,18 @@ static double _calculateLb(const tsp_t* tsp, const tspNode_t* node, int nextCity
     return node->lb + costFromTo - (costFrom + costTo) / 2;
 }
 
+// pruned nodes are otherwise only dropped once popped, so the frontier is compacted after large enough improvements
+static void _purgeFrontier(tspSolverData_t* solverData) {
+    double solutionPriority = solverData->solution->priority;
+    if (queueSize(solverData->queue) < PURGE_MIN_NODES ||
+        solutionPriority > solverData->purgePriority * (1 - PURGE_MIN_IMPROVEMENT))
+        return;
+
+    solverData->nPurged +=
+        queueFilter(solverData->queue, __tspNodeIsPromisingFun, &solutionPriority, __tspNodeDestroyFun);
+    solverData->purgePriority = solutionPriority;
+}
+
 static void _updateBestTour(tspSolverData_t* solverData, const tspNode_t* finalNode) {
     const tsp_t* tsp = solverData->tsp;
     tspSolution_t* solution = solverData->solution;
@@ -73,30 +113,94 @@ static void _updateBestTour(tspSolverData_t* solverData, const tspNode_t* finalN
         solution->hasSolution = true;
         solution->cost = cost;
         solution->priority = cost * MAX_CITIES + solution->tour[tsp->nCities - 1];
+        _purgeFrontier(solverData);
     }
 }
 
-static void _visitNeighbors(tspSolverData_t* solverData, const tspNode_t* parent) {
+#ifdef __LAZY_EXPANSION__
+typedef struct {
+    int city;
+    double lb;
+    double priority;
+} tspChild_t;
+
+static int _sortedChildren(const tsp_t* tsp, const tspNode_t* parent, tspChild_t* children) {
+    int parentCurrentCity = tspNodeCurrentCity(parent);
+    int nChildren = 0;
+    for (int cityNumber = 0; cityNumber < tsp->nCities; cityNumber++) {
+        if (tspIsNeighbour(tsp, parentCurrentCity, cityNumber) && !_isCityInTour(parent, cityNumber) &&
+            _isCanonicalOrientation(tsp, parent, cityNumber)) {
+            double lb = _calculateLb(tsp, parent, cityNumber);
+            tspChild_t child = {cityNumber, lb, lb * MAX_CITIES + cityNumber};
+            int i = nChildren++;
+            for (; i > 0 && children[i - 1].priority > child.priority; i--)
+                children[i] = children[i - 1];
+            children[i] = child;
+        }
+    }
+    return nChildren;
+}
+
+static int _nextSibling(const tspSolverData_t* solverData, const tspChild_t* children, int nChildren, int sibling) {
+    while (sibling < nChildren && children[sibling].lb > solverData->solution->cost)
+        sibling++;
+    return sibling;
+}
+
+// only the best pending child is created, the parent is pushed back as a cursor to its next sibling
+static bool _visitNeighbors(tspSolverData_t* solverData, tspNode_t* parent) {
+    const tsp_t* tsp = solverData->tsp;
+    int parentCurrentCity = tspNodeCurrentCity(parent);
+    tspChild_t children[MAX_CITIES];
+    int nChildren = _sortedChildren(tsp, parent, children);
+
+    int sibling = _nextSibling(solverData, children, nChildren, parent->sibling);
+    if (sibling == nChildren)
+        return false;
+
+    const tspChild_t* child = &children[sibling];
+    double cost = parent->cost + tsp->roadCosts[parentCurrentCity][child->city];
+    tspNode_t* nextNode = tspNodeCreateExt(parent, cost, child->lb, child->city);
+    STATS(solverData->nCreated++);
+    queuePush(solverData->queue, nextNode);
+
+    sibling = _nextSibling(solverData, children, nChildren, sibling + 1);
+    if (sibling == nChildren)
+        return false;
+
+    parent->sibling = sibling;
+    parent->priority = children[sibling].priority;
+    queuePush(solverData->queue, parent);
+    return true;
+}
+#else
+static bool _visitNeighbors(tspSolverData_t* solverData, tspNode_t* parent) {
     const tsp_t* tsp = solverData->tsp;
     int parentCurrentCity = tspNodeCurrentCity(parent);
     for (int cityNumber = 0; cityNumber < tsp->nCities; cityNumber++) {
-        if (tspIsNeighbour(tsp, parentCurrentCity, cityNumber) && !_isCityInTour(parent, cityNumber)) {
+        if (tspIsNeighbour(tsp, parentCurrentCity, cityNumber) && !_isCityInTour(parent, cityNumber) &&
+            _isCanonicalOrientation(tsp, parent, cityNumber)) {
             double lb = _calculateLb(tsp, parent, cityNumber);
             if (lb > solverData->solution->cost)
                 continue;
             double cost = parent->cost + tsp->roadCosts[parentCurrentCity][cityNumber];
             tspNode_t* nextNode = tspNodeCreateExt(parent, cost, lb, cityNumber);
+            STATS(solverData->nCreated++);
             queuePush(solverData->queue, nextNode);
         }
     }
+    return false;
 }
+#endif
 
-static void _processNode(tspSolverData_t* solverData, tspNode_t* node) {
+static bool _processNode(tspSolverData_t* solverData, tspNode_t* node) {
     const tsp_t* tsp = solverData->tsp;
-    if ((node->length == tsp->nCities) && tspIsNeighbour(tsp, tspNodeCurrentCity(node), 0))
+    STATS(solverData->nExpanded++);
+    if ((node->length == tsp->nCities) && tspIsNeighbour(tsp, tspNodeCurrentCity(node), 0)) {
         _updateBestTour(solverData, node);
-    else
-        _visitNeighbors(solverData, node);
+        return false;
+    }
+    return _visitNeighbors(solverData, node);
 }
 
 tspSolution_t* tspSolve(const tsp_t* tsp, double maxTourCost) {
@@ -104,19 +208,27 @@ tspSolution_t* tspSolve(const tsp_t* tsp, double maxTourCost) {
     solverData.tsp = tsp;
     solverData.solution = tspSolutionCreate(maxTourCost);
     solverData.queue = queueCreate(__tspNodeCmpFun);
+    solverData.purgePriority = solverData.solution->priority;
+    solverData.nPurged = 0;
+    solverData.nExpanded = 0;
+    solverData.nCreated = 0;
 
     tspNode_t* startNode = tspNodeCreate(0, _calculateInitialLb(tsp), 1, 0);
-    _processNode(&solverData, startNode);
-    tspNodeDestroy(startNode);
+    if (!_processNode(&solverData, startNode))
+        tspNodeDestroy(startNode);
 
     while (true) {
         tspNode_t* node = _getNextNode(solverData.queue, solverData.solution->priority);
         if (node == NULL)
             break;
-        _processNode(&solverData, node);
-        tspNodeDestroy(node);
+        if (!_processNode(&solverData, node))
+            tspNodeDestroy(node);
     }
 
+    STATS_LOG("expanded nodes = %lu", solverData.nExpanded);
+    STATS_LOG("created nodes = %lu", solverData.nCreated);
+    STATS_LOG("purged nodes = %lu (%.1f MB)", solverData.nPurged,
+              solverData.nPurged * (sizeof(tspNode_t) + sizeof(void*)) / (1024.0 * 1024.0));
     queueDestroy(solverData.queue, __tspNodeDestroyFun);
     return solverData.solution;
 }
@@ -10,8 +10,10 @@ typedef struct _priorityQueue priorityQueue_t;
 
 priorityQueue_t* queueCreate(int (*cmpFun)(void*, void*));
 void queueDestroy(priorityQueue_t* queue, void (*delFun)(void*));
+size_t queueSize(priorityQueue_t* queue);
 void* queuePeek(priorityQueue_t* queue);
 void* queuePop(priorityQueue_t* queue);
 void* queuePush(priorityQueue_t* queue, void* element);
+size_t queueFilter(priorityQueue_t* queue, bool (*keepFun)(void*, void*), void* arg, void (*delFun)(void*));
 
 #endif //__UTILS__QUEUE_H__